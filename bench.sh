@@ -0,0 +1,43 @@
+# benchmark the specialized and the generic search traversal side by side on
+# a random sequence -> results are written to bench_output.txt
+# set BASELINE to a git revision to benchmark its build as well, e.g. the
+# commit before the traversal was specialized
+awk 'BEGIN { srand(1); for (i = 0; i < 200000; ++i) printf "%s", substr("ACGT", int(rand() * 4) + 1, 1); print "" }' > build/bench_sequence.txt;
+rm -f bench_output.txt;
+kernels="specialized generic";
+if [ -n "$BASELINE" ]; then
+  rm -rf build/baseline;
+  git worktree prune;
+  git worktree add --detach build/baseline "$BASELINE" || exit 1;
+  mkdir -p build/baseline/build;
+  (cd build/baseline/build && cmake -DCMAKE_BUILD_TYPE=Release .. && make) || exit 1;
+  kernels="$kernels baseline";
+fi
+for d in 1 2; do
+  for m in silent statistics motif; do
+    for kernel in $kernels; do
+      binary=build/ACME;
+      flag="";
+      if [ $kernel = generic ]; then flag="-gk"; fi;
+      if [ $kernel = baseline ]; then binary=build/baseline/build/ACME; fi;
+      start=$(date +%s.%N);
+      $binary -i build/bench_sequence.txt -f 10 -d $d -maxl 12 -m $m $flag > /dev/null;
+      end=$(date +%s.%N);
+      echo "$start $end" | awk -v d=$d -v m=$m -v k=$kernel '{ printf "-d %s -m %-10s %-11s %.3f s\n", d, m, k, $2 - $1 }' >> bench_output.txt;
+    done
+  done
+done
+# the verification cutoff: 0 walks the suffix tree for every branch, the
+# default 32 verifies sparse branches on flat windows
+for d in 1 2; do
+  for c in 0 32; do
+    start=$(date +%s.%N);
+    build/ACME -i build/bench_sequence.txt -f 10 -d $d -maxl 12 -m silent -c $c > /dev/null;
+    end=$(date +%s.%N);
+    echo "$start $end" | awk -v d=$d -v c=$c '{ printf "-d %s -c %-2s %.3f s\n", d, c, $2 - $1 }' >> bench_output.txt;
+  done
+done
+if [ -n "$BASELINE" ]; then
+  git worktree remove --force build/baseline;
+fi
+cat bench_output.txt;
@@ -24,21 +24,37 @@
 
 
 #include "acme.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
 
 ACME::ACME(std::istream &is,
            std::ostream& os,
-           unsigned minLength,
-           unsigned maxLength,
-           unsigned minFrequency,
-           unsigned maxDistance,
-           unsigned mode) :
+           const Options& options) :
            is(is),
            os(os),
-           minLength(minLength),
-           maxLength(maxLength),
-           minFrequency(minFrequency),
-           maxDistance(maxDistance),
-           mode(mode) {
+           minLength(options.minLength),
+           maxLength(options.maxLength),
+           minFrequency(options.minFrequency),
+           maxDistance(options.maxDistance),
+           mode(options.mode),
+           verifyCutoff(options.verifyCutoff),
+           memoryLimit(options.memoryLimit),
+           tmpDirectory(options.tmpDirectory),
+           truncate(options.truncate),
+           genericKernel(options.genericKernel),
+           dustLevel(options.dustLevel),
+           maskRegions(options.maskRegions),
+           maxOccurrences(options.maxOccurrences),
+           maskedCount(0),
+           timeLimit(options.timeLimit),
+           searchMemoryLimit(options.searchMemoryLimit),
+           skipPrefixes(options.skipPrefixes.begin(), options.skipPrefixes.end()),
+           skipLength(0),
+           startTime(std::chrono::steady_clock::now()) {
+  for (const auto& prefix : this->skipPrefixes) {
+    this->skipLength = std::max(this->skipLength, prefix.size());
+  }
 
   // read input stream to a sequence
   std::string line;
@@ -47,25 +63,63 @@ ACME::ACME(std::istream &is,
     seqan::append(seq, line); // append line to seq
   }
 
-  // construct suffix tree from sequence
-  STIndex stIndex(seq);
+  // positions and frequencies must fit into STSize (see common.h)
+  if (seqan::length(seq) > std::numeric_limits<STSize>::max()) {
+    throw std::runtime_error("the sequence is too long for " + std::to_string(sizeof(STSize) * 8) +
+                             "-bit positions, build with -DACME_WIDE_POSITIONS=ON.");
+  }
 
-  // construct cast search object
-  this->search = cast::Search(stIndex, this->maxDistance);
+  // mask low-complexity regions before the index is built
+  if (this->maskRegions != nullptr) {
+    this->maskedCount += mask::regions(seq, *this->maskRegions);
+  }
+  this->maskedCount += mask::dust(seq, this->dustLevel);
 
   // init statistics vector
-  this->statistics = std::vector<unsigned>(101); // Motifs are not expected to be longer than 100
+  this->statistics = std::vector<STSize>(101); // Motifs are not expected to be longer than 100
 
   // print motif models start message
   if (this->mode == 2) {
     this->os << "# Motif Models (motif : frequency : [list of occurrences]):\n";
   }
 
-  // perform search
-  ACME::CASTMotifsExtraction();
+  // perform search, exact motifs do not need the search space trie
+  if (this->maxDistance > 0 && this->memoryLimit > 0) {
+    // the search runs on the sequence and keeps its occurrences on disk, the
+    // partitions of the suffix array are only needed for the first list
+    std::vector<partition::Partition> partitions = ACME::buildPartitions(seq);
+    try {
+      this->search = cast::Search(seq, partitions, this->tmpDirectory, this->maxDistance);
+    } catch (...) {
+      partition::remove(partitions);
+      throw;
+    }
+    partition::remove(partitions);
+    try {
+      ACME::CASTMotifsExtraction();
+    } catch (...) {
+      cast::remove(this->search);
+      throw;
+    }
+    cast::remove(this->search);
+  } else if (this->maxDistance > 0) {
+    // construct suffix tree from sequence
+    STIndex stIndex(seq);
+    if (this->truncate) {
+      truncated::createIndex(stIndex, this->maxLength + 1);
+    }
+
+    // construct cast search object
+    this->search = cast::Search(stIndex, this->maxDistance, this->verifyCutoff, this->maxLength + 1);
+
+    ACME::CASTMotifsExtraction();
+  } else {
+    ACME::exactMotifsExtraction(seq);
+  }
 
   // print statistics
   ACME::printStat();
+  ACME::printStop();
 
   return;
 }
@@ -84,37 +138,145 @@ bool ACME::isValid() {
 }
 
 // Check if the current motif (branch) is promising, i.e. if is interesting.
+// A branch with more occurrences than maxOccurrences is skipped together with
+// all its extensions, and recorded for the statistics. Branches up to the
+// distance threshold long match every position and are never skipped.
 bool ACME::isPromising() {
+  // subtrees completed by an earlier run are not searched again, the
+  // ancestors of the branch were checked before
+  if (!this->skipPrefixes.empty() && cast::getLength(this->search) <= this->skipLength) {
+    seqan::String<char> motif = cast::getMotif(this->search);
+    if (this->skipPrefixes.count(std::string(seqan::begin(motif), seqan::end(motif))) > 0) {
+      return false;
+    }
+  }
   if (cast::getFrequency(this->search) >= this->minFrequency &&
       cast::getLength(this->search) <= this->maxLength) {
+    if (this->maxOccurrences > 0 && cast::getLength(this->search) > this->maxDistance &&
+        cast::getFrequency(this->search) > this->maxOccurrences) {
+      this->skipped.push_back(std::make_pair(cast::getMotif(this->search),
+                                             cast::getFrequency(this->search)));
+      return false;
+    }
     return true;
   } else {
     return false;
   }
 }
 
+// Check if a motif starts with a prefix completed by an earlier run.
+bool ACME::isSkipped(const char* motif, size_t length) {
+  if (this->skipPrefixes.empty()) return false;
+  for (size_t prefixLength = 1; prefixLength <= std::min(length, this->skipLength); ++prefixLength) {
+    if (this->skipPrefixes.count(std::string(motif, prefixLength)) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Check if the search exceeds the time limit or the memory limit of the
+// search space trie, and set the reason to stop.
+bool ACME::isOverBudget() {
+  if (this->timeLimit > 0 &&
+      std::chrono::steady_clock::now() - this->startTime >= std::chrono::seconds(this->timeLimit)) {
+    this->stopReason = "time limit";
+    return true;
+  }
+  if (this->maxDistance > 0 && this->searchMemoryLimit > 0 &&
+      cast::getMemoryUsage(this->search) > this->searchMemoryLimit) {
+    this->stopReason = "memory limit";
+    return true;
+  }
+  return false;
+}
+
+// Record the prefixes whose subtrees are complete when the search stops, i.e.
+// the ones completed by this run and by earlier runs. Prefixes that extend
+// another completed prefix are left out.
+void ACME::stop(const std::vector<seqan::String<char> >& completedByRun) {
+  std::set<std::string> completed(this->skipPrefixes);
+  for (const auto& prefix : completedByRun) {
+    completed.insert(std::string(seqan::begin(prefix), seqan::end(prefix)));
+  }
+  for (const auto& prefix : completed) {
+    bool extendsCompleted = false;
+    for (size_t length = 1; length < prefix.size() && !extendsCompleted; ++length) {
+      extendsCompleted = completed.count(prefix.substr(0, length)) > 0;
+    }
+    if (!extendsCompleted) {
+      this->completedPrefixes.push_back(seqan::String<char>(prefix));
+    }
+  }
+}
+
 // Search and output approximate motifs using cache aware search space
 // traversal (CAST).
+// The traversal is selected once: specialized for the distance thresholds 1
+// and 2 and for the output mode, or the generic one (which reads both at
+// runtime) if genericKernel is set.
+void ACME::CASTMotifsExtraction() {
+  // nothing to search if the whole sequence is masked
+  if (this->search.alphabetSize == 0) return;
+  if (this->genericKernel) {
+    ACME::CASTMotifsExtraction<cast::genericDistance, genericMode>();
+    return;
+  }
+  switch (this->maxDistance) {
+    case 1: ACME::CASTMotifsExtraction<1>(); break;
+    case 2: ACME::CASTMotifsExtraction<2>(); break;
+    default: ACME::CASTMotifsExtraction<cast::genericDistance>(); break;
+  }
+}
+
+// Select the traversal for the output mode.
+template <unsigned MaxDistance>
+void ACME::CASTMotifsExtraction() {
+  switch (this->mode) {
+    case 0: ACME::CASTMotifsExtraction<MaxDistance, 0>(); break;
+    case 1: ACME::CASTMotifsExtraction<MaxDistance, 1>(); break;
+    default: ACME::CASTMotifsExtraction<MaxDistance, 2>(); break;
+  }
+}
+
+// The traversal for the distance threshold MaxDistance and the output mode
+// Mode, both may be generic, i.e. taken from the members at runtime.
+template <unsigned MaxDistance, unsigned Mode>
 void ACME::CASTMotifsExtraction() {
+  // the limits are checked once the search has processed budgetInterval
+  // occurrences, a step processes about the frequency of the current branch
+  // (all of it on disk, where one step can take long)
+  size_t work = 0;
   // perform DFS in postorder
   while (true) {
+    // stop cleanly at a limit, the motifs of the current search branch and
+    // its ancestors are not output yet
+    work += 1 + this->search.branchVector.back().frequency;
+    if (work >= budgetInterval) {
+      work = 0;
+      if (ACME::isOverBudget()) {
+        ACME::stop(cast::getCompletedPrefixes(this->search));
+        return;
+      }
+    }
     // if current search branch is promising
     // then continue search down the tree
     if(ACME::isPromising()) {
-      cast::goDown(this->search);
+      cast::goDown<MaxDistance>(this->search);
       continue;
     } else {
       // else if current search branch is not promising
       //  if can go right then go right
       //  else, repeat go up and output valid motifs until can go right
-      while(!cast::goRight(this->search)) {
+      while(!cast::goRight<MaxDistance>(this->search)) {
         // if can not go up, then we must be back at root and end DFS
         if(!cast::goUp(this->search)) {
           return;
         }
-        // if motif is valid print motif and add info to statistics
-        if (ACME::isValid()) {
-          ACME::printMotif();
+        // if motif is valid print motif and add info to statistics,
+        // nothing is output in silent mode
+        if (Mode >= 1 && ACME::isValid()) {
+          if (Mode >= 2) ACME::printMotif();
           ACME::collectStat();
         }
       }
@@ -123,6 +285,95 @@ void ACME::CASTMotifsExtraction() {
   return;
 }
 
+// Search and output exact motifs from the lcp intervals of the suffix array,
+// which is built in partitions on disk if a memory limit is set.
+void ACME::exactMotifsExtraction(seqan::String<char>& seq) {
+  // select the output of every motif once for the mode
+  exact::Visitor visit = [](const exact::Motif&) {};
+  if (this->mode == 2) {
+    visit = [this](const exact::Motif& motif) {
+      ACME::printMotif(motif);
+      ACME::collectStat(motif.length);
+    };
+  } else if (this->mode == 1) {
+    visit = [this](const exact::Motif& motif) {
+      ACME::collectStat(motif.length);
+    };
+  }
+  // motifs completed by an earlier run are not output again
+  if (!this->skipPrefixes.empty()) {
+    visit = [this, visit](const exact::Motif& motif) {
+      if (!ACME::isSkipped(seqan::begin(motif.text, seqan::Standard()) + motif.position, motif.length)) {
+        visit(motif);
+      }
+    };
+  }
+  // motifs with more occurrences than maxOccurrences are skipped with their
+  // extensions, as in isPromising. A motif occurs at most as often as its
+  // first character, so it is skipped if its first character occurs too often.
+  if (this->maxOccurrences > 0) {
+    std::vector<STSize> counts(256, 0);
+    for (size_t i = 0; i < seqan::length(seq); ++i) {
+      ++counts[static_cast<unsigned char>(seq[i])];
+    }
+    counts[static_cast<unsigned char>(mask::maskCharacter)] = 0;
+    for (unsigned character = 0; character < counts.size(); ++character) {
+      const char first = static_cast<char>(character);
+      if (counts[character] >= this->minFrequency && counts[character] > this->maxOccurrences &&
+          !ACME::isSkipped(&first, 1)) {
+        seqan::String<char> prefix;
+        seqan::appendValue(prefix, first);
+        this->skipped.push_back(std::make_pair(prefix, counts[character]));
+      }
+    }
+    visit = [this, visit, counts](const exact::Motif& motif) {
+      if (counts[static_cast<unsigned char>(motif.text[motif.position])] <= this->maxOccurrences) {
+        visit(motif);
+      }
+    };
+  }
+  // the limits are checked every budgetInterval suffixes
+  size_t steps = 0;
+  exact::Interrupt interrupt = [this, &steps]() {
+    return ++steps % budgetInterval == 0 && ACME::isOverBudget();
+  };
+  std::vector<seqan::String<char> > completed;
+  if (this->memoryLimit == 0) {
+    // construct suffix tree from sequence
+    STIndex stIndex(seq);
+    if (this->truncate) {
+      truncated::createIndex(stIndex, this->maxLength + 1);
+    }
+    if (!exact::enumerate(stIndex, this->minLength, this->maxLength, this->minFrequency,
+                          visit, interrupt, completed)) {
+      ACME::stop(completed);
+    }
+    return;
+  }
+  // the partitions are deleted even if the enumeration fails
+  std::vector<partition::Partition> partitions = ACME::buildPartitions(seq);
+  try {
+    if (!exact::enumerate(seq, partitions, this->minLength, this->maxLength, this->minFrequency,
+                          visit, interrupt, completed)) {
+      ACME::stop(completed);
+    }
+  } catch (...) {
+    partition::remove(partitions);
+    throw;
+  }
+  partition::remove(partitions);
+}
+
+// Build the suffix array partitions of the sequence within the memory limit.
+// The sequence itself is held in memory next to one partition, and the
+// partitions are compared up to the maximum motif length as with truncate.
+std::vector<partition::Partition> ACME::buildPartitions(const seqan::String<char>& seq) {
+  if (this->memoryLimit <= seqan::length(seq)) {
+    throw std::runtime_error("the memory limit is too small to hold the sequence.");
+  }
+  return partition::build(seq, this->tmpDirectory, this->memoryLimit - seqan::length(seq), this->maxLength + 1);
+}
+
 // Print the current search branch (motif).
 void ACME::printMotif() {
   // do not print if silent mode is set
@@ -132,21 +383,44 @@ void ACME::printMotif() {
   this->os << " ";
   this->os << cast::getFrequency(this->search);
   this->os << " ";
+  // print occurrences, they are streamed from the search
+  this->os << "[";
+  cast::forEachOccurrence(this->search, [this](STSize occurrence) {
+    this->os << " " << occurrence;
+  });
+  this->os << " ]";
+  this->os << "\n";
+}
+
+// Print an exact motif, reading its characters from the text and streaming its
+// occurrences from the index.
+void ACME::printMotif(const exact::Motif& motif) {
+  // do not print if silent mode is set
+  if (this->mode < 2) return;
+  // print motif and frequency
+  this->os.write(seqan::begin(motif.text, seqan::Standard()) + motif.position, motif.length);
+  this->os << " ";
+  this->os << motif.frequency;
+  this->os << " ";
   // print occurrences
   this->os << "[";
-    for (auto occurrence : cast::getOccurrences(this->search)) {
+  motif.occurrences.forEach([this](STSize occurrence) {
     this->os << " " << occurrence;
-    }
+  });
   this->os << " ]";
   this->os << "\n";
 }
 
 // Add the current search branch (motif) to the statistics.
 void ACME::collectStat() {
+  ACME::collectStat(cast::getLength(this->search));
+}
+
+// Add a motif of the given length to the statistics.
+void ACME::collectStat(unsigned length) {
   // if mode statistics is set
   if (this->mode < 1) return;
-  // add current search branch (motif) to the statistics
-  unsigned length = cast::getLength(this->search);
+  // add motif to the statistics
   if (length >= 100) length = 100; // statistics vector is 101 long
   this->statistics[length] += 1;
 }
@@ -157,7 +431,7 @@ void ACME::printStat() {
   if (this->mode < 1) return;
   // print the statistics
   this->os << "# Statistics (motif length : number of motifs): \n";
-    int sum = 0;
+    STSize sum = 0;
     for (size_t i = 0; i < this->statistics.size(); ++i) {
       if (this->statistics[i] != 0) {
       this->os << "# " << i << " : " << this->statistics[i] << "\n";
@@ -165,4 +439,26 @@ void ACME::printStat() {
       }
     }
   this->os << "# total number of motifs: " << sum << "\n";
+  // print what was excluded from the search
+  if (this->maskedCount > 0) {
+    this->os << "# masked positions: " << this->maskedCount << "\n";
+  }
+  if (!this->skipped.empty()) {
+    this->os << "# Skipped prefixes (prefix : frequency): \n";
+    for (const auto& prefix : this->skipped) {
+      this->os << "# " << prefix.first << " : " << prefix.second << "\n";
+    }
+  }
+}
+
+// Print where a search stopped at a limit, also in silent mode.
+void ACME::printStop() {
+  if (this->stopReason.empty()) return;
+  this->os << "# Stopped at the " << this->stopReason << ", the search is incomplete.\n";
+  this->os << "# Completed prefixes (resume with --skip-prefixes): ";
+  for (size_t i = 0; i < this->completedPrefixes.size(); ++i) {
+    if (i > 0) this->os << ",";
+    this->os << this->completedPrefixes[i];
+  }
+  this->os << "\n";
 }
@@ -33,16 +33,42 @@
 // user to retrieve the set of approximate motifs of a sequence. The isValid
 // method differs from the original ACME algorithm, in that this implementation
 // does not check if a motif is left-maximal and right-maximal.
+// If the maximum distance is 0, the motifs are extracted from the lcp intervals
+// of the suffix array instead (see exact.h), which yields the same output.
 //
-// The parameters that the user must provide are:
-//  is: the input stream
-//  os: the output stream
-//  min_length: the minimum length of a valid motif
-//  max_length: the maxmimum length of a valid motif
-//  min_frequency: the mimimum frequency (no. of occurrences) of a valid motif
-//  max_distance: the maximum hamming distance between an occurrence and the
-//  motif mode: choose between silent, statistics and motif. motif will output
-//  all valid motifs
+// The parameters that the user must provide are the input stream is, the
+// output stream os and the options:
+//  minLength: the minimum length of a valid motif
+//  maxLength: the maxmimum length of a valid motif
+//  minFrequency: the mimimum frequency (no. of occurrences) of a valid motif
+//  maxDistance: the maximum hamming distance between an occurrence and the
+//  motif
+//  mode: choose between silent, statistics and motif. motif will output all
+//  valid motifs
+//  verifyCutoff: the frequency below which a search branch is verified
+//  directly against the text instead of the suffix tree (0 disables)
+//  memoryLimit: the memory limit of the index in bytes (0 disables), the
+//  suffix array is built in partitions on disk to stay within it, and the
+//  search of approximate motifs keeps its occurrences on disk (see cast.h)
+//  tmpDirectory: the directory the partitions are stored in
+//  truncate: build the index only up to depth maxLength + 1 (see truncated.h)
+//  genericKernel: use the generic traversal instead of the one specialized
+//  for the distance threshold and mode (for benchmarks, see cast.h)
+//  dustLevel: mask the repetitive intervals of windows with a higher DUST
+//  score (see mask.h, 0 disables)
+//  maskRegions: a BED stream of regions to mask (nullptr disables)
+//  maxOccurrences: skip motifs longer than maxDistance (and their extensions)
+//  with more occurrences (0 disables)
+//  timeLimit: the time limit of the search in seconds, the search stops once
+//  it is exceeded (0 disables)
+//  searchMemoryLimit: the memory limit of the search of approximate motifs in
+//  bytes, the search stops once the index and the search space trie exceed it
+//  (0 disables)
+//  skipPrefixes: prefixes whose subtrees were completed by an earlier run
+//  that was stopped at a limit, they are skipped by the search
+//
+// A search that is stopped at a limit still outputs the motifs found so far
+// and the statistics, followed by the prefixes whose subtrees are complete.
 ////////////////////////////////////////////////////////////////////////////////
 
 
@@ -50,10 +76,38 @@
 
 #include "common.h"
 #include "cast.h"
+#include "exact.h"
+#include "truncated.h"
+#include "mask.h"
 #include <seqan/index.h>
+#include <chrono>
 #include <iostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 class ACME{
+public:
+  // The options of a run, see above.
+  struct Options {
+    unsigned minLength = 1;
+    unsigned maxLength = 20;
+    unsigned minFrequency = 2;
+    unsigned maxDistance = 0;
+    unsigned mode = 2;
+    unsigned verifyCutoff = 32;
+    size_t memoryLimit = 0;
+    std::string tmpDirectory = ".";
+    bool truncate = false;
+    bool genericKernel = false;
+    unsigned dustLevel = 0;
+    std::istream* maskRegions = nullptr;
+    STSize maxOccurrences = 0;
+    unsigned timeLimit = 0;
+    size_t searchMemoryLimit = 0;
+    std::vector<std::string> skipPrefixes;
+  };
 private:
   std::istream& is;
   std::ostream& os;
@@ -62,20 +116,47 @@ private:
   unsigned minFrequency;
   unsigned maxDistance;
   unsigned mode; // mode 0, 1, 2: silent, statistics, motif
-  std::vector<unsigned> statistics;
+  unsigned verifyCutoff;
+  size_t memoryLimit;
+  std::string tmpDirectory;
+  bool truncate;
+  bool genericKernel;
+  static const unsigned genericMode = 3; // the mode is checked at runtime
+  unsigned dustLevel;
+  std::istream* maskRegions;
+  STSize maxOccurrences;
+  STSize maskedCount; // the number of masked positions
+  std::vector<std::pair<seqan::String<char>, STSize> > skipped; // skipped prefixes
+  unsigned timeLimit;
+  size_t searchMemoryLimit;
+  std::set<std::string> skipPrefixes; // completed by an earlier run
+  size_t skipLength; // length of the longest prefix in skipPrefixes
+  std::chrono::steady_clock::time_point startTime;
+  static const size_t budgetInterval = 1024; // suffixes or occurrences between checks of the limits
+  std::string stopReason; // the limit the search stopped at, empty if complete
+  std::vector<seqan::String<char> > completedPrefixes;
+  std::vector<STSize> statistics;
   cast::Search search;
   void CASTMotifsExtraction();
+  template <unsigned MaxDistance>
+  void CASTMotifsExtraction();
+  template <unsigned MaxDistance, unsigned Mode>
+  void CASTMotifsExtraction();
+  void exactMotifsExtraction(seqan::String<char>& seq);
+  std::vector<partition::Partition> buildPartitions(const seqan::String<char>& seq);
   bool isValid();
   bool isPromising();
+  bool isSkipped(const char* prefix, size_t length);
+  bool isOverBudget();
+  void stop(const std::vector<seqan::String<char> >& completedByRun);
   void printMotif();
+  void printMotif(const exact::Motif& motif);
   void collectStat();
+  void collectStat(unsigned length);
   void printStat();
+  void printStop();
 public:
   ACME(std::istream& is,
        std::ostream& os,
-       unsigned min_length,
-       unsigned max_length,
-       unsigned min_frequency,
-       unsigned max_distance,
-       unsigned mode);
+       const Options& options);
 };
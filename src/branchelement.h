@@ -27,11 +27,34 @@
 
 #include "common.h"
 #include "occurrenceelement.h"
+#include <cstdint>
+#include <memory>
 #include <vector>
 
+// The flat occurrences of a sparse search branch: the text positions gathered
+// when the branch dropped below the verification cutoff, and the characters
+// following each of them. The characters are transposed, so that the
+// characters of all positions at one offset form a contiguous row with one
+// lane per position, and an extension compares a whole row at once.
+struct FlatWindow {
+    unsigned length; // the length of the branch the window was gathered at
+    size_t lanes; // the lanes of a row, a multiple of the lanes of a block
+    size_t rows; // the number of gathered offsets
+    std::vector<STSize> positionVector; // starting position of each lane
+    // characters[offset * lanes + lane] is the character at position +
+    // length + offset, or the mask character past the end of the text
+    std::vector<char> characters;
+};
+
 struct BranchElement {
     unsigned alphabetIndex;
-    unsigned frequency;
+    STSize frequency;
     unsigned length;
     std::vector<OccurrenceElement> occurrenceVector;
+    // flat representation of the occurrences, used once the frequency of the
+    // branch drops below the verification cutoff (see cast::Search). The
+    // window is shared by the branch and its extensions.
+    std::shared_ptr<const FlatWindow> window;
+    std::vector<uint8_t> distanceVector; // distance of each lane to the motif
+    std::vector<uint32_t> laneMasks; // one bit per lane that is an occurrence
   };
@@ -24,6 +24,18 @@
 
 
 #include "cast.h"
+#include "mask.h"
+#include <algorithm>
+#include <bitset>
+#include <cstdio>
+#include <stdexcept>
+#include <unistd.h>
+#include <utility>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace cast {
 
@@ -34,14 +46,110 @@ namespace {
 // Extend the current motif (search branch) by the character
 // alphabet[alphabetIndex], i.e. move the search space trie node to the child
 // with the character alphabet[alphabetIndex].
+// MaxDistance is the distance threshold, or genericDistance to use
+// search.maxDistance.
+template <unsigned MaxDistance>
 void extend(Search& search, unsigned alphabetIndex);
+
+// Extend a branch whose frequency is below the verification cutoff by
+// comparing the next character of each occurrence directly against the text.
+template <unsigned MaxDistance>
+void verify(Search& search, unsigned alphabetIndex);
+
+// The number of flat occurrences that are read from or written to disk at
+// once.
+const size_t blockSize = 1 << 16;
+
+// A flat occurrence of a search on disk.
+struct FlatOccurrence {
+  STSize position;
+  STSize distance;
+};
+
+// Verify a branch of a search on disk, the flat list of the current branch is
+// streamed from its level file into the level file of the new branch.
+template <unsigned MaxDistance>
+void verifyOnDisk(Search& search, unsigned alphabetIndex);
+
+// The level file holding the flat list of the branch at level, it is created
+// if needed.
+std::fstream& levelFile(Search& search, size_t level);
+
+// Read the first count flat occurrences of the level file in blocks, and
+// call visitBlock for every block.
+template <typename TVisitBlock>
+void readLevel(Search& search, size_t level, STSize count, TVisitBlock visitBlock);
+
+// Throw an error if a level file cannot be accessed.
+void fail(const std::string& path);
+
+// The distance threshold of a search, known at compile time unless
+// MaxDistance is genericDistance.
+template <unsigned MaxDistance>
+inline unsigned maxDistanceOf(const Search& search) {
+  return (MaxDistance == genericDistance) ? search.maxDistance : MaxDistance;
+}
+
+// The number of lanes (positions) of a flat window that are compared at once,
+// one bit of a lane mask each.
+const size_t blockLanes = 32;
+
+// The most characters gathered per position of a flat window, deeper
+// extensions read the text directly.
+const size_t maxWindowRows = 64;
+
+// Replace the suffix tree occurrences of a branch element by a flat window of
+// the text positions (and their distances) that they represent.
+void flatten(Search& search, BranchElement& branchElement);
+
+// Extend one block of lanes of a flat window by character: row holds the next
+// character of every lane and distances their distances so far. The new
+// distances are written to newDistances, and the mask of the lanes that stay
+// within maxDistance and do not reach a masked position is returned.
+uint32_t verifyBlock(const char* row, const uint8_t* distances, const char character,
+                     const uint8_t maxDistance, uint8_t* newDistances);
+
+// The frequency of a suffix tree node, i.e. the number of suffixes below it.
+// It is read from the index, the nodes are not annotated.
+inline STSize frequencyOf(const STIterator& node) {
+  return seqan::countOccurrences(node);
+}
+
+// The length of the subsequence represented by a suffix tree node.
+inline STSize lengthOf(const STIterator& node) {
+  return seqan::repLength(node);
+}
+
+// The number of bytes held by a fibre of the index.
+template <typename TString>
+inline size_t stringBytes(const TString& string) {
+  return seqan::length(string) * sizeof(typename seqan::Value<TString>::Type);
+}
+
+// The number of bytes reserved by a vector of a branch element.
+template <typename T>
+inline size_t vectorBytes(const std::vector<T>& vector) {
+  return vector.capacity() * sizeof(T);
+}
+
+// The index of the lowest lane set in a nonzero lane mask.
+inline unsigned lowestLane(uint32_t mask) {
+#if defined(__GNUC__)
+  return __builtin_ctz(mask);
+#else
+  unsigned lane = 0;
+  for (; (mask & 1) == 0; mask >>= 1) ++lane;
+  return lane;
+#endif
+}
 }  // anonymous namespace
 
 
 // Move the search space trie node one step down, i.e. add the first character
 // of the alphabet to the back of the motif.
+template <unsigned MaxDistance>
 bool goDown(Search& search) {
-  extend(search, 0);
+  extend<MaxDistance>(search, 0);
   return true;
 }
 
@@ -56,32 +164,70 @@ bool goUp(Search& search) {
 
 // Move the search space trie node one step to the right, i.e. increment the
 // last character of the motif.
+template <unsigned MaxDistance>
 bool goRight(Search& search) {
   if (search.branchVector.back().alphabetIndex != search.alphabetSize - 1 && // if last character of alphabet
       search.branchVector.back().alphabetIndex != search.alphabetSize) { // or special root symbol
     unsigned nextAlphabetIndex = search.branchVector.back().alphabetIndex + 1;
     goUp(search);
-    extend(search, nextAlphabetIndex);
+    extend<MaxDistance>(search, nextAlphabetIndex);
     return true;
   } else {return false;}
 }
 
+// The traversal is compiled for the common small distance thresholds, for
+// any other threshold given at runtime.
+template bool goDown<1>(Search& search);
+template bool goDown<2>(Search& search);
+template bool goDown<genericDistance>(Search& search);
+template bool goRight<1>(Search& search);
+template bool goRight<2>(Search& search);
+template bool goRight<genericDistance>(Search& search);
+
 // Get the list of all occurrences of the current search branch (motif
 // candidate, i.e the top of the branch vector).
-std::vector<unsigned> getOccurrences(Search& search) {
-  BranchElement branchElement = search.branchVector.back();
-  std::vector<unsigned> ret;
-  for (OccurrenceElement oe : branchElement.occurrenceVector) {
+std::vector<STSize> getOccurrences(Search& search) {
+  std::vector<STSize> ret;
+  forEachOccurrence(search, [&ret](STSize occurrence) {
+    ret.push_back(occurrence);
+  });
+  return ret;
+}
+
+// Visit all occurrences of the current search branch in order, without
+// collecting them first.
+void forEachOccurrence(Search& search, const std::function<void(STSize)>& visit) {
+  const BranchElement& branchElement = search.branchVector.back();
+  // a search on disk streams the flat list from the level file
+  if (search.stIndex == nullptr) {
+    readLevel(search, search.branchVector.size() - 1, branchElement.frequency,
+              [&visit](const std::vector<FlatOccurrence>& block) {
+      for (const FlatOccurrence& occurrence : block) {
+        visit(occurrence.position);
+      }
+    });
+    return;
+  }
+  // a verified branch already stores its occurrences as text positions
+  if (branchElement.frequency < search.verifyCutoff) {
+    const std::vector<STSize>& positions = branchElement.window->positionVector;
+    for (size_t block = 0; block < branchElement.laneMasks.size(); ++block) {
+      for (uint32_t mask = branchElement.laneMasks[block]; mask != 0; mask &= mask - 1) {
+        visit(positions[block * blockLanes + lowestLane(mask)]);
+      }
+    }
+    return;
+  }
+  for (const OccurrenceElement& oe : branchElement.occurrenceVector) {
     for (auto occurrence : seqan::getOccurrences(oe.stIter)) {
-      ret.push_back(occurrence);
+      visit(occurrence);
     }
   }
-  return ret;
 }
 
 // Get the frequency (number of occurrences) of the current search branch
 // (motif candidate).
-unsigned getFrequency(Search& search) {
+STSize getFrequency(Search& search) {
   return search.branchVector.back().frequency;
 }
 
@@ -101,40 +247,81 @@ seqan::String<char> getMotif(Search& search) {
   return motif;
 }
 
-// A representation of the search space trie (all possible motifs) and relevant
-// parameters for the CAST algorithm.
-Search::Search(STIndex& stIndex, const unsigned maxDistance) :
-maxDistance(maxDistance), stIndex(stIndex) {
-  // annotate suffix tree with the frequency (number of occurrences of
-  // represented subsequence in sequence) and the length of each nodes
-  // represented subsequence in property maps.
-  // access the property maps through: this->pmFrequency and this->pmLength
-  STIterator stIterator(stIndex);
-  std::stack<STIterator> iterStack;
-  seqan::goRoot(stIterator);   // move iterator to the root node.
-  iterStack.push(stIterator);  // push root to stack, nonrecursive solution
-  seqan::resizeVertexMap(this->pmFrequency, this->stIndex);
-  seqan::resizeVertexMap(this->pmLength, this->stIndex);
-  while(!iterStack.empty()) {  // DFS in preorder each node and assign property
-    seqan::assignProperty(this->pmFrequency, seqan::value(iterStack.top()), seqan::countOccurrences(iterStack.top()));
-    seqan::assignProperty(this->pmLength, seqan::value(iterStack.top()), seqan::repLength(iterStack.top()));
-    STIterator topDown = iterStack.top();
-    STIterator topRight = iterStack.top();
-    iterStack.pop();
-    if (seqan::goDown(topDown)) {
-      iterStack.push(topDown);
+// Get the prefixes whose subtrees of the search space trie were completely
+// traversed, i.e. the left siblings of the current search branch and of all
+// its ancestors, as the trie is traversed depth first in alphabet order.
+std::vector<seqan::String<char> > getCompletedPrefixes(Search& search) {
+  std::vector<seqan::String<char> > prefixes;
+  seqan::String<char> motif;
+  for (size_t i = 1; i < search.branchVector.size(); ++i) { // character at position 0 is root, i.e. empty
+    for (unsigned alphabetIndex = 0; alphabetIndex < search.branchVector[i].alphabetIndex; ++alphabetIndex) {
+      prefixes.push_back(motif);
+      seqan::appendValue(prefixes.back(), search.alphabet[alphabetIndex]);
     }
-    if (seqan::goRight(topRight)) {
-      iterStack.push(topRight);
+    motif += search.alphabet[ search.branchVector[i].alphabetIndex ];
+  }
+  return prefixes;
+}
+
+// Get an estimate of the memory in bytes used by the index, and by the
+// occurrences of the current search branch and its ancestors that are held in
+// memory.
+size_t getMemoryUsage(Search& search) {
+  size_t bytes = stringBytes(*search.text);
+  // a search on disk has no index
+  if (search.stIndex != nullptr) {
+    STIndex& stIndex = *search.stIndex;
+    bytes += stringBytes(seqan::indexSA(stIndex)) +
+             stringBytes(seqan::indexLcp(stIndex)) +
+             stringBytes(seqan::indexChildtab(stIndex));
+  }
+  const FlatWindow* window = nullptr;
+  for (const BranchElement& branchElement : search.branchVector) {
+    bytes += sizeof(BranchElement) +
+             vectorBytes(branchElement.occurrenceVector) +
+             vectorBytes(branchElement.distanceVector) +
+             vectorBytes(branchElement.laneMasks);
+    // a window is shared by a branch and its extensions
+    if (branchElement.window && branchElement.window.get() != window) {
+      window = branchElement.window.get();
+      bytes += sizeof(FlatWindow) +
+               vectorBytes(window->positionVector) +
+               vectorBytes(window->characters);
     }
   }
+  return bytes;
+}
+
+// Delete the level files of a search on disk.
+void remove(Search& search) {
+  for (size_t level = 0; level < search.levelFiles.size(); ++level) {
+    search.levelFiles[level]->close();
+    std::remove((search.levelPath + std::to_string(level)).c_str());
+  }
+  search.levelFiles.clear();
+}
+
+// A representation of the search space trie (all possible motifs) and relevant
+// parameters for the CAST algorithm. The frequency and the length of the
+// suffix tree nodes are read from the index when they are visited, so the
+// search adds no memory that grows with the sequence.
+Search::Search(STIndex& stIndex,
+               const unsigned maxDistance,
+               const unsigned verifyCutoff,
+               const unsigned depth) :
+maxDistance(maxDistance), verifyCutoff(verifyCutoff), depth(depth), stIndex(&stIndex),
+text(&seqan::indexText(stIndex)) {
+  STIterator stIterator(stIndex);
 
   // generate the alphabet from the suffix tree, i.e. the alphabet over which
   // the search space traversal is performed.
   seqan::goRoot(stIterator); // move iterator to the root node
   seqan::goDown(stIterator); // move iterator down one step
   do { // visit all children of root and append leading character of edges to alphabet
-    this->alphabet.push_back(seqan::parentEdgeFirstChar(stIterator));
+    // masked positions are never part of a motif
+    if (seqan::parentEdgeFirstChar(stIterator) != mask::maskCharacter) {
+      this->alphabet.push_back(seqan::parentEdgeFirstChar(stIterator));
+    }
   } while(seqan::goRight(stIterator));
   // calculate alphabet size
   this->alphabetSize = this->alphabet.size();
@@ -153,9 +340,70 @@ maxDistance(maxDistance), stIndex(stIndex) {
   // and the branches of its ancestors.
   this->branchVector.push_back(BranchElement{
     this->alphabetSize, // one greater than largest index in alphabet - unique character representing root
-    seqan::getProperty(pmFrequency, value(stIterator)), // number of leafs, i.e. no. of matches between root (empty pattern) and sequence
+    frequencyOf(stIterator), // number of leafs, i.e. no. of matches between root (empty pattern) and sequence
     0, // length of the search branch (motif)
-    occurrenceVector
+    occurrenceVector,
+    {}, {}, {} // no flat occurrences yet
+  });
+  // a sequence shorter than the cutoff is verified directly from the start
+  if (this->branchVector.back().frequency < this->verifyCutoff) {
+    flatten(*this, this->branchVector.back());
+  }
+}
+
+// A search space trie over text without a suffix tree, whose flat lists are
+// stored in directory. Every branch is below the verification cutoff, the
+// root list holds all positions of the text in the order of the suffix array
+// partitions.
+Search::Search(const seqan::String<char>& text,
+               const std::vector<partition::Partition>& partitions,
+               const std::string& directory,
+               const unsigned maxDistance) :
+maxDistance(maxDistance), verifyCutoff(std::numeric_limits<STSize>::max()),
+depth(std::numeric_limits<unsigned>::max()), stIndex(nullptr),
+text(&text), levelPath(directory + "/acme_" + std::to_string(getpid()) + "_level_") {
+  const size_t n = seqan::length(text);
+  // generate the alphabet from the text, in the order of the suffix array.
+  // masked positions are never part of a motif
+  std::vector<bool> present(256, false);
+  for (size_t p = 0; p < n; ++p) {
+    present[static_cast<unsigned char>(text[p])] = true;
+  }
+  present[static_cast<unsigned char>(mask::maskCharacter)] = false;
+  for (unsigned character = 0; character < present.size(); ++character) {
+    if (present[character]) {
+      this->alphabet.push_back(static_cast<char>(character));
+    }
+  }
+  this->alphabetSize = this->alphabet.size();
+
+  // write the root list, every position matches the empty motif
+  try {
+    std::fstream& root = levelFile(*this, 0);
+    partition::Cursor cursor(partitions);
+    std::vector<FlatOccurrence> block;
+    block.reserve(blockSize);
+    for (size_t i = 0; i < n; ++i) {
+      STSize suffix = 0;
+      STSize lcp = 0;
+      partition::next(cursor, suffix, lcp);
+      block.push_back(FlatOccurrence{suffix, 0});
+      if (block.size() == blockSize || i + 1 == n) {
+        root.write(reinterpret_cast<const char*>(block.data()), block.size() * sizeof(FlatOccurrence));
+        block.clear();
+      }
+    }
+    root.flush();
+    if (!root) fail(this->levelPath + "0");
+  } catch (...) {
+    remove(*this);
+    throw;
+  }
+  this->branchVector.push_back(BranchElement{
+    this->alphabetSize, // unique character representing root
+    static_cast<STSize>(n), // every position matches the empty pattern
+    0, // length of the search branch (motif)
+    {}, {}, {}, {} // the occurrences are on disk
   });
 }
 
@@ -164,74 +412,331 @@ namespace {
 // Extend the search pattern by the character given by alphabetIndex.
 // i.e. push a new branch element with alphabetIndex and the corresponding
 // occurrenceelements.
+template <unsigned MaxDistance>
 void extend(Search& search, unsigned alphabetIndex) {
-  // the current branch that we are expanding.
-  BranchElement branchElement = search.branchVector.back();
+  // sparse branches, and all branches of a search on disk, are extended
+  // directly on the text
+  if (search.stIndex == nullptr || search.branchVector.back().frequency < search.verifyCutoff) {
+    verify<MaxDistance>(search, alphabetIndex);
+    return;
+  }
+  const unsigned maxDistance = maxDistanceOf<MaxDistance>(search);
+  const char character = search.alphabet[alphabetIndex];
+  // the current branch that we are expanding, it is not modified before the
+  // new branch element is pushed.
+  const BranchElement& branchElement = search.branchVector.back();
   // the amount of occurrences of the current search branch (motif).
-  unsigned newBranchFrequency = 0;
+  STSize newBranchFrequency = 0;
   // the new occurrenceVector
   std::vector<OccurrenceElement> occurrenceVector;
   // for each occurrence element that belongs to the branch element
-  for (OccurrenceElement occurrenceElement: branchElement.occurrenceVector) {
+  for (const OccurrenceElement& occurrenceElement: branchElement.occurrenceVector) {
     // if the length of the sequence represented by the occurrenceElement
     // is the same length as the search branch (motif)
-    if ( branchElement.length == seqan::getProperty(search.pmLength, value(occurrenceElement.stIter))) {
+    if ( branchElement.length == lengthOf(occurrenceElement.stIter)) {
       // if the occurrenceElement is a leaf, then we cannot expand and continue
       if (seqan::isLeaf(occurrenceElement.stIter)) {
         continue;
       }
-      // expand the node of occurrenceElement to all its children
       STIterator child = occurrenceElement.stIter;
+      // if the occurrenceElement is already at the distance threshold, only
+      // the child with the expanded character can match
+      if (occurrenceElement.distance == maxDistance) {
+        if (seqan::goDown(child, character)) {
+          occurrenceVector.push_back(OccurrenceElement{child, occurrenceElement.distance});
+          newBranchFrequency += frequencyOf(child);
+        }
+        continue;
+      }
+      // expand the node of occurrenceElement to all its children
       seqan::goDown(child); // the left most child
       do { // visit all children
         // update the distance new_distance of child to the current search branch (motif)
         // if the first character of the traversed edge to child
         // does not equal the currently expanded character alphabetIndex
         // increment the new distance by 1 (or the distance given by distance measure)
-        unsigned new_distance = occurrenceElement.distance;
-        if (seqan::parentEdgeFirstChar(child) != search.alphabet[alphabetIndex]
-            && seqan::parentEdgeFirstChar(child) != search.alphabet[alphabetIndex]) {
-          new_distance += 1;
+        // a masked position never matches
+        char edgeCharacter = seqan::parentEdgeFirstChar(child);
+        if (edgeCharacter == mask::maskCharacter) {
+          continue;
         }
+        unsigned new_distance = occurrenceElement.distance + (edgeCharacter != character);
         // if the new_distance is less than the distance threshold
         // add the child as a new occurrence to occurrenceArray
         // and increase the newBranchFrequency accordingly
-        if (new_distance <= search.maxDistance) {
+        if (new_distance <= maxDistance) {
           occurrenceVector.push_back(OccurrenceElement{child, new_distance});
-          newBranchFrequency += seqan::getProperty(search.pmFrequency, value(child));
+          newBranchFrequency += frequencyOf(child);
         }
       } while(seqan::goRight(child));
 
     // else if the length of the sequence represented by the occurrenceElement
     // is longer than the current search branch (motif)
     } else {
-      unsigned new_distance = occurrenceElement.distance;
-      STIterator child = occurrenceElement.stIter;
+      const STIterator& child = occurrenceElement.stIter;
       // if the expanded character (alphabetIndex) does not equal
       // the corresponding character of the edge from the occurrence node to child
-      // increment the new distance by 1
-      if (seqan::parentEdgeLabel(child)[branchElement.length - seqan::parentRepLength(child)]
-        != search.alphabet[alphabetIndex]) {
-        new_distance += 1;
+      // increment the new distance by 1, a masked position never matches
+      char edgeCharacter = seqan::parentEdgeLabel(child)[branchElement.length - seqan::parentRepLength(child)];
+      if (edgeCharacter == mask::maskCharacter) {
+        continue;
       }
+      unsigned new_distance = occurrenceElement.distance + (edgeCharacter != character);
       // if the new_distance is less than the distance threshold
       // add the child as a new occurrence to occurrenceArray
       // and increase the newBranchFrequency accordingly
-      if (new_distance <= search.maxDistance) {
+      if (new_distance <= maxDistance) {
         occurrenceVector.push_back(OccurrenceElement{child, new_distance});
-        newBranchFrequency += seqan::getProperty(search.pmFrequency, value(child));
+        newBranchFrequency += frequencyOf(child);
       }
     }
   }
-  // push a new branch element to the back of the branch array
-  search.branchVector.push_back(BranchElement{
+  BranchElement newBranchElement{
     alphabetIndex, // the expanded character at alphabetIndex
     newBranchFrequency, // the number of approximate matches of the branch pattern (motif)
     branchElement.length + 1, // the length of the current branch pattern (motif)
-    occurrenceVector
-  });
+    std::move(occurrenceVector),
+    {}, {}, {} // no flat occurrences yet
+  };
+  // switch to direct verification if the new branch is sparse
+  if (newBranchFrequency < search.verifyCutoff) {
+    flatten(search, newBranchElement);
+  }
+  // push a new branch element to the back of the branch array
+  search.branchVector.push_back(std::move(newBranchElement));
   return;
 }
+
+// Extend the search pattern by the character given by alphabetIndex for a
+// branch whose occurrences are stored as a flat window of text positions.
+// The occurrences of the new branch are the lanes whose next character keeps
+// the distance to the motif within the distance threshold. Lanes are never
+// reordered, so the output equals that of the suffix tree walk.
+// The next characters of all lanes are read from one row of the window and
+// compared blockLanes at a time (see verifyBlock), extensions beyond the
+// gathered rows read the text directly.
+template <unsigned MaxDistance>
+void verify(Search& search, unsigned alphabetIndex) {
+  if (search.stIndex == nullptr) {
+    verifyOnDisk<MaxDistance>(search, alphabetIndex);
+    return;
+  }
+  const BranchElement& branchElement = search.branchVector.back();
+  const FlatWindow& window = *branchElement.window;
+  const char character = search.alphabet[alphabetIndex];
+  const size_t offset = branchElement.length - window.length;
+  // distances are counted in bytes, a threshold of 255 or more keeps all
+  const uint8_t maxDistance = static_cast<uint8_t>(
+    std::min<unsigned>(maxDistanceOf<MaxDistance>(search), 255));
+  const size_t blocks = branchElement.laneMasks.size();
+  std::vector<uint8_t> distanceVector(window.lanes);
+  std::vector<uint32_t> laneMasks(blocks);
+  STSize frequency = 0;
+  if (offset < window.rows) {
+    const char* row = window.characters.data() + offset * window.lanes;
+    for (size_t block = 0; block < blocks; ++block) {
+      const size_t lane = block * blockLanes;
+      laneMasks[block] = branchElement.laneMasks[block] &
+        verifyBlock(row + lane, branchElement.distanceVector.data() + lane, character,
+                    maxDistance, distanceVector.data() + lane);
+      frequency += std::bitset<blockLanes>(laneMasks[block]).count();
+    }
+  } else {
+    const char* textBegin = seqan::begin(*search.text, seqan::Standard());
+    const size_t textLength = seqan::length(*search.text);
+    for (size_t block = 0; block < blocks; ++block) {
+      for (uint32_t mask = branchElement.laneMasks[block]; mask != 0; mask &= mask - 1) {
+        const size_t lane = block * blockLanes + lowestLane(mask);
+        const size_t next = static_cast<size_t>(window.positionVector[lane]) + branchElement.length;
+        // an occurrence that reaches the end of the text or a masked position
+        // cannot be extended
+        if (next >= textLength || textBegin[next] == mask::maskCharacter) {
+          continue;
+        }
+        // increment the distance by 1 if the next character is a mismatch
+        const unsigned newDistance = branchElement.distanceVector[lane] + (textBegin[next] != character);
+        if (newDistance <= maxDistance) {
+          distanceVector[lane] = static_cast<uint8_t>(newDistance);
+          laneMasks[block] |= uint32_t(1) << (lane - block * blockLanes);
+          ++frequency;
+        }
+      }
+    }
+  }
+  BranchElement newBranchElement{
+    alphabetIndex, // the expanded character at alphabetIndex
+    frequency, // every lane is one occurrence
+    branchElement.length + 1, // the length of the current branch pattern (motif)
+    std::vector<OccurrenceElement>(), // no suffix tree nodes are tracked anymore
+    branchElement.window, // the window is shared with the current branch
+    std::move(distanceVector),
+    std::move(laneMasks)
+  };
+  // push a new branch element to the back of the branch array
+  search.branchVector.push_back(std::move(newBranchElement));
+  return;
+}
+
+uint32_t verifyBlock(const char* row, const uint8_t* distances, const char character,
+                     const uint8_t maxDistance, uint8_t* newDistances) {
+#if defined(__AVX2__)
+  const __m256i characters = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row));
+  // 1 in every mismatching lane
+  const __m256i mismatches = _mm256_andnot_si256(
+    _mm256_cmpeq_epi8(characters, _mm256_set1_epi8(character)), _mm256_set1_epi8(1));
+  const __m256i newDistance = _mm256_adds_epu8(
+    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(distances)), mismatches);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(newDistances), newDistance);
+  // newDistance <= maxDistance, and the lane is not masked
+  const __m256i within = _mm256_cmpeq_epi8(
+    _mm256_min_epu8(newDistance, _mm256_set1_epi8(static_cast<char>(maxDistance))), newDistance);
+  const __m256i masked = _mm256_cmpeq_epi8(characters, _mm256_set1_epi8(mask::maskCharacter));
+  return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_andnot_si256(masked, within)));
+#elif defined(__SSE2__)
+  // the same as above in two halves of 16 lanes
+  uint32_t laneMask = 0;
+  for (size_t half = 0; half < blockLanes; half += 16) {
+    const __m128i characters = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + half));
+    const __m128i mismatches = _mm_andnot_si128(
+      _mm_cmpeq_epi8(characters, _mm_set1_epi8(character)), _mm_set1_epi8(1));
+    const __m128i newDistance = _mm_adds_epu8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(distances + half)), mismatches);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(newDistances + half), newDistance);
+    const __m128i within = _mm_cmpeq_epi8(
+      _mm_min_epu8(newDistance, _mm_set1_epi8(static_cast<char>(maxDistance))), newDistance);
+    const __m128i masked = _mm_cmpeq_epi8(characters, _mm_set1_epi8(mask::maskCharacter));
+    laneMask |= static_cast<uint32_t>(_mm_movemask_epi8(_mm_andnot_si128(masked, within))) << half;
+  }
+  return laneMask;
+#else
+  uint32_t laneMask = 0;
+  for (size_t lane = 0; lane < blockLanes; ++lane) {
+    const unsigned newDistance = std::min<unsigned>(distances[lane] + (row[lane] != character), 255);
+    newDistances[lane] = static_cast<uint8_t>(newDistance);
+    if (row[lane] != mask::maskCharacter && newDistance <= maxDistance) {
+      laneMask |= uint32_t(1) << lane;
+    }
+  }
+  return laneMask;
+#endif
+}
+
+// Collect the text positions of all suffix tree nodes of the branch element,
+// every position inherits the distance of its node, and gather the characters
+// that follow them up to the depth of the search.
+void flatten(Search& search, BranchElement& branchElement) {
+  std::shared_ptr<FlatWindow> window(new FlatWindow());
+  window->length = branchElement.length;
+  for (const OccurrenceElement& oe : branchElement.occurrenceVector) {
+    for (auto occurrence : seqan::getOccurrences(oe.stIter)) {
+      window->positionVector.push_back(occurrence);
+      branchElement.distanceVector.push_back(static_cast<uint8_t>(std::min(oe.distance, 255u)));
+    }
+  }
+  branchElement.occurrenceVector.clear();
+  const size_t count = window->positionVector.size();
+  // the lanes are padded to whole blocks, padding lanes are never set
+  window->lanes = (count + blockLanes - 1) / blockLanes * blockLanes;
+  window->rows = search.depth > branchElement.length ?
+    std::min<size_t>(search.depth - branchElement.length, maxWindowRows) : 0;
+  branchElement.distanceVector.resize(window->lanes, 0);
+  branchElement.laneMasks.assign(window->lanes / blockLanes, 0);
+  for (size_t lane = 0; lane < count; ++lane) {
+    branchElement.laneMasks[lane / blockLanes] |= uint32_t(1) << (lane % blockLanes);
+  }
+  // gather the rows, row by row so that they are written contiguously
+  const char* textBegin = seqan::begin(*search.text, seqan::Standard());
+  const size_t textLength = seqan::length(*search.text);
+  window->characters.assign(window->rows * window->lanes, mask::maskCharacter);
+  for (size_t offset = 0; offset < window->rows; ++offset) {
+    char* row = window->characters.data() + offset * window->lanes;
+    for (size_t lane = 0; lane < count; ++lane) {
+      const size_t next = static_cast<size_t>(window->positionVector[lane]) + branchElement.length + offset;
+      if (next < textLength) {
+        row[lane] = textBegin[next];
+      }
+    }
+  }
+  branchElement.window = std::move(window);
+}
+
+// The same as verify, for flat lists in level files.
+template <unsigned MaxDistance>
+void verifyOnDisk(Search& search, unsigned alphabetIndex) {
+  const BranchElement& branchElement = search.branchVector.back();
+  const char* textBegin = seqan::begin(*search.text, seqan::Standard());
+  const size_t textLength = seqan::length(*search.text);
+  const char character = search.alphabet[alphabetIndex];
+  const unsigned length = branchElement.length;
+  const unsigned maxDistance = maxDistanceOf<MaxDistance>(search);
+  const size_t level = search.branchVector.size() - 1;
+  std::fstream& file = levelFile(search, level + 1);
+  file.clear();
+  file.seekp(0);
+  // the kept occurrences are written in blocks
+  std::vector<FlatOccurrence> kept;
+  kept.reserve(blockSize);
+  STSize frequency = 0;
+  auto write = [&file, &kept, &frequency]() {
+    file.write(reinterpret_cast<const char*>(kept.data()), kept.size() * sizeof(FlatOccurrence));
+    frequency += kept.size();
+    kept.clear();
+  };
+  readLevel(search, level, branchElement.frequency, [&](const std::vector<FlatOccurrence>& block) {
+    for (const FlatOccurrence& occurrence : block) {
+      // an occurrence that reaches the end of the text or a masked position
+      // cannot be extended
+      const size_t next = static_cast<size_t>(occurrence.position) + length;
+      if (next >= textLength || textBegin[next] == mask::maskCharacter) {
+        continue;
+      }
+      // increment the distance by 1 if the next character is a mismatch
+      STSize new_distance = occurrence.distance + (textBegin[next] != character);
+      if (new_distance <= maxDistance) {
+        kept.push_back(FlatOccurrence{occurrence.position, new_distance});
+        if (kept.size() == blockSize) write();
+      }
+    }
+  });
+  write();
+  file.flush();
+  if (!file) fail(search.levelPath + std::to_string(level + 1));
+  search.branchVector.push_back(BranchElement{
+    alphabetIndex, // the expanded character at alphabetIndex
+    frequency, // every position is one occurrence
+    length + 1, // the length of the current branch pattern (motif)
+    {}, {}, {}, {} // the occurrences are on disk
+  });
+}
+
+std::fstream& levelFile(Search& search, size_t level) {
+  while (search.levelFiles.size() <= level) {
+    std::string path = search.levelPath + std::to_string(search.levelFiles.size());
+    search.levelFiles.emplace_back(new std::fstream(
+      path, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary));
+    if (!*search.levelFiles.back()) fail(path);
+  }
+  return *search.levelFiles[level];
+}
+
+template <typename TVisitBlock>
+void readLevel(Search& search, size_t level, STSize count, TVisitBlock visitBlock) {
+  std::fstream& file = levelFile(search, level);
+  file.clear();
+  file.seekg(0);
+  std::vector<FlatOccurrence> block;
+  while (count > 0) {
+    block.resize(std::min<size_t>(count, blockSize));
+    file.read(reinterpret_cast<char*>(block.data()), block.size() * sizeof(FlatOccurrence));
+    if (!file) fail(search.levelPath + std::to_string(level));
+    visitBlock(block);
+    count -= block.size();
+  }
+}
+
+void fail(const std::string& path) {
+  throw std::runtime_error("could not access the search file '" + path + "'.");
+}
 } // anonymous namespace
 
 }  // namespace cast
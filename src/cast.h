@@ -51,8 +51,27 @@
 //  getFrequency()
 //  getLength()
 //  getOccurrences()
+//  forEachOccurrence()
 //  getMotif()
 //
+// A traversal that is stopped early (e.g. at a time limit) can be resumed
+// from the prefixes whose subtrees it completed, see getCompletedPrefixes().
+//
+// Once the frequency of a search branch drops below the verification cutoff,
+// the occurrences are no longer tracked as suffix tree nodes but as flat lists
+// of text positions and distances. The characters following the positions
+// are gathered once into a transposed window, and deeper extensions of such a
+// branch compare the next character of all positions at once (with SSE2 or
+// AVX2 where available), which is cheaper than walking the suffix tree for
+// sparse branches.
+//
+// For sequences whose index does not fit into memory, the search can run
+// without a suffix tree: every branch is verified directly, starting from all
+// positions of the text in suffix array order (read from the partitions, see
+// partition.h), and the flat lists of the current branch and its ancestors
+// are kept in one file per level on disk and streamed in blocks. Only the
+// sequence and the blocks are held in memory.
+//
 ////////////////////////////////////////////////////////////////////////////////
 
 
@@ -60,31 +79,56 @@
 
 #include "common.h"
 #include "branchelement.h"
+#include "partition.h"
 #include <seqan/index.h>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace cast {
 
+// The distance threshold of a traversal that is only known at runtime, the
+// traversal is compiled for the distance thresholds 1 and 2 as well.
+const unsigned genericDistance = std::numeric_limits<unsigned>::max();
+
 struct Search {
   public:
     Search(STIndex& stIndex,
+           const unsigned maxDistance,
+           const unsigned verifyCutoff = 0,
+           const unsigned depth = std::numeric_limits<unsigned>::max());
+    Search(const seqan::String<char>& text,
+           const std::vector<partition::Partition>& partitions,
+           const std::string& directory,
            const unsigned maxDistance);
     Search() {}
     unsigned maxDistance;
-    STIndex stIndex;
-    seqan::String<unsigned> pmFrequency;
-    seqan::String<unsigned> pmLength;
+    STSize verifyCutoff; // branches with lower frequency are verified directly
+    unsigned depth; // no motif is extended beyond depth characters
+    STIndex* stIndex; // the index the search runs on, nullptr on disk
+    const seqan::String<char>* text; // the text, it must outlive the search
+    std::string levelPath; // the path of the level files without the level
+    std::vector<std::unique_ptr<std::fstream> > levelFiles; // flat lists on disk
     std::vector<BranchElement> branchVector;
     std::vector<char> alphabet;
     unsigned alphabetSize;
 };
 
+template <unsigned MaxDistance = genericDistance>
 bool goRight(Search& search);
+template <unsigned MaxDistance = genericDistance>
 bool goDown(Search& search);
 bool goUp(Search& search);
-std::vector<unsigned> getOccurrences(Search& search);
-unsigned getFrequency(Search& search);
+std::vector<STSize> getOccurrences(Search& search);
+void forEachOccurrence(Search& search, const std::function<void(STSize)>& visit);
+STSize getFrequency(Search& search);
 unsigned getLength(Search& search);
 seqan::String<char> getMotif(Search& search);
+std::vector<seqan::String<char> > getCompletedPrefixes(Search& search);
+size_t getMemoryUsage(Search& search);
+void remove(Search& search);
 
 }  // namespace cast
@@ -26,6 +26,24 @@
 #pragma once
 
 #include <seqan/index.h>
+#include <cstdint>
+
+// The type of positions, frequencies and lengths of the suffix tree.
+// 32-bit positions keep the index compact, sequences of 2^32 characters or
+// more require a build with ACME_WIDE_POSITIONS (cmake -DACME_WIDE_POSITIONS=ON).
+#ifdef ACME_WIDE_POSITIONS
+typedef uint64_t STSize;
+#else
+typedef uint32_t STSize;
+#endif
+
+namespace seqan {
+// store suffix array entries (and thus all occurrences) as STSize
+template <>
+struct SAValue<seqan::String<char> > {
+  typedef STSize Type;
+};
+}  // namespace seqan
 
 // TODO: remove typedefs and make template based
 typedef seqan::Index<seqan::String<char>, seqan::IndexEsa<> > STIndex;
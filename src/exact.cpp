@@ -0,0 +1,350 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2017 Jonas Spenger
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "exact.h"
+#include "mask.h"
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+namespace exact {
+
+// Hide the helper functions in an anonymous namespace so that they cannot be
+// accessed from other files.
+namespace {
+
+// Enumerate the lcp intervals of a suffix array that is read entry by entry
+// from the cursor, and report the motifs of every interval in postorder.
+// Returns false if it was interrupted, next is then the first suffix whose
+// motifs are not all reported.
+template <typename TCursor>
+bool scan(const seqan::String<char>& text,
+          TCursor& cursor,
+          const unsigned minLength,
+          const unsigned maxLength,
+          const unsigned minFrequency,
+          const Visitor& visit,
+          const Interrupt& interrupt,
+          STSize& next);
+
+// The prefixes (up to maxLength) whose motifs are all reported before the
+// suffix next, i.e. the left siblings of the prefixes of next in the
+// lexicographically ordered search space trie.
+std::vector<seqan::String<char> > completedBefore(const seqan::String<char>& text,
+                                                   STSize next,
+                                                   const unsigned maxLength);
+
+// Report the motifs on the edge leading to the lcp interval [lb, rb], i.e. all
+// prefixes of the interval's sequence longer than parentLength and at most
+// length long that satisfy the length and frequency thresholds. position is
+// the first suffix of the interval.
+template <typename TCursor>
+void report(const seqan::String<char>& text, TCursor& cursor,
+            size_t lb, size_t rb, STSize position,
+            STSize length, STSize parentLength,
+            const unsigned minLength, const unsigned maxLength,
+            const unsigned minFrequency, const Visitor& visit);
+
+// The occurrences of the lcp interval [lb, rb], read through the cursor.
+template <typename TCursor>
+class CursorOccurrences : public Occurrences {
+  public:
+    CursorOccurrences(TCursor& cursor, size_t lb, size_t rb) :
+    cursor(cursor), lb(lb), rb(rb) {}
+    void forEach(const std::function<void(STSize)>& visit) const {
+      this->cursor.forEach(this->lb, this->rb, visit);
+    }
+  private:
+    TCursor& cursor;
+    size_t lb;
+    size_t rb;
+};
+
+// Reads the suffix array of an index together with its permuted lcp array.
+template <typename TSA>
+struct MemoryCursor {
+  const TSA& sa;
+  const std::vector<STSize>& plcp;
+  size_t position;
+  // read the next suffix and its lcp with the preceding suffix
+  void next(STSize& suffix, STSize& lcp) {
+    suffix = sa[position];
+    lcp = plcp[suffix];
+    ++position;
+  }
+  // visit the suffixes in range [lb, rb] of the suffix array
+  void forEach(size_t lb, size_t rb, const std::function<void(STSize)>& visit) {
+    for (size_t i = lb; i <= rb; ++i) {
+      visit(sa[i]);
+    }
+  }
+};
+
+// Reads the suffix array of an index together with its lcp table, e.g. of a
+// truncated index (see truncated.h).
+template <typename TSA, typename TLcp>
+struct TableCursor {
+  const TSA& sa;
+  const TLcp& lcp;
+  size_t position;
+  // read the next suffix and its lcp with the preceding suffix
+  void next(STSize& suffix, STSize& suffixLcp) {
+    suffix = sa[position];
+    suffixLcp = (position > 0) ? lcp[position - 1] : 0;
+    ++position;
+  }
+  // visit the suffixes in range [lb, rb] of the suffix array
+  void forEach(size_t lb, size_t rb, const std::function<void(STSize)>& visit) {
+    for (size_t i = lb; i <= rb; ++i) {
+      visit(sa[i]);
+    }
+  }
+};
+
+// Reads a suffix array that is partitioned on disk (see partition.h).
+struct PartitionCursor {
+  partition::Cursor& cursor;
+  void next(STSize& suffix, STSize& lcp) {
+    partition::next(cursor, suffix, lcp);
+  }
+  void forEach(size_t lb, size_t rb, const std::function<void(STSize)>& visit) {
+    partition::forEachSuffix(cursor, lb, rb, visit);
+  }
+};
+}  // anonymous namespace
+
+
+// Enumerate all exact motifs of the sequence of stIndex.
+// If the index already has an lcp table, it is scanned together with the
+// suffix array. Otherwise the lcp array is computed in text order (permuted lcp) from the suffix
+// array, so that only one additional array of the length of the sequence is
+// needed. The lcp intervals are then enumerated with a stack in a single scan
+// over the suffix array, popping an interval reports it in postorder.
+// Returns false if the enumeration was interrupted, completedPrefixes then
+// holds the prefixes whose motifs were all reported.
+bool enumerate(STIndex& stIndex,
+               const unsigned minLength,
+               const unsigned maxLength,
+               const unsigned minFrequency,
+               const Visitor& visit,
+               const Interrupt& interrupt,
+               std::vector<seqan::String<char> >& completedPrefixes) {
+  const seqan::String<char>& text = seqan::indexText(stIndex);
+  seqan::indexRequire(stIndex, seqan::EsaSA());
+  const auto& sa = seqan::indexSA(stIndex);
+  const size_t n = seqan::length(text);
+  if (n == 0) return true;
+  STSize next = 0;
+
+  if (seqan::indexSupplied(stIndex, seqan::EsaLcp())) {
+    const auto& lcp = seqan::indexLcp(stIndex);
+    TableCursor<typename std::decay<decltype(sa)>::type,
+                typename std::decay<decltype(lcp)>::type> cursor{sa, lcp, 0};
+    if (scan(text, cursor, minLength, maxLength, minFrequency, visit, interrupt, next)) return true;
+    completedPrefixes = completedBefore(text, next, maxLength);
+    return false;
+  }
+
+  // permuted lcp: plcp[p] is the length of the longest common prefix of the
+  // suffix p and the suffix preceding it in the suffix array.
+  // plcp is first filled with the preceding suffix and then overwritten in
+  // place, since plcp[p] >= plcp[p - 1] - 1 this takes linear time.
+  std::vector<STSize> plcp(n);
+  plcp[sa[0]] = n; // no preceding suffix
+  for (size_t i = 1; i < n; ++i) {
+    plcp[sa[i]] = sa[i - 1];
+  }
+  STSize h = 0;
+  for (size_t p = 0; p < n; ++p) {
+    if (plcp[p] == n) {
+      plcp[p] = h = 0;
+      continue;
+    }
+    size_t q = plcp[p];
+    while (p + h < n && q + h < n && text[p + h] == text[q + h]) {
+      ++h;
+    }
+    plcp[p] = h;
+    if (h > 0) --h;
+  }
+
+  MemoryCursor<typename std::decay<decltype(sa)>::type> cursor{sa, plcp, 0};
+  if (scan(text, cursor, minLength, maxLength, minFrequency, visit, interrupt, next)) return true;
+  completedPrefixes = completedBefore(text, next, maxLength);
+  return false;
+}
+
+// Enumerate all exact motifs of text from its suffix array partitions on disk.
+// The partitions are read sequentially in order, and together form the suffix
+// array and lcp array of the whole text up to the depth they were built with,
+// so the output is the same as above for a truncated index.
+bool enumerate(const seqan::String<char>& text,
+               const std::vector<partition::Partition>& partitions,
+               const unsigned minLength,
+               const unsigned maxLength,
+               const unsigned minFrequency,
+               const Visitor& visit,
+               const Interrupt& interrupt,
+               std::vector<seqan::String<char> >& completedPrefixes) {
+  if (seqan::length(text) == 0) return true;
+  partition::Cursor partitionCursor(partitions);
+  PartitionCursor cursor{partitionCursor};
+  STSize next = 0;
+  if (scan(text, cursor, minLength, maxLength, minFrequency, visit, interrupt, next)) return true;
+  completedPrefixes = completedBefore(text, next, maxLength);
+  return false;
+}
+
+namespace {
+
+template <typename TCursor>
+bool scan(const seqan::String<char>& text,
+          TCursor& cursor,
+          const unsigned minLength,
+          const unsigned maxLength,
+          const unsigned minFrequency,
+          const Visitor& visit,
+          const Interrupt& interrupt,
+          STSize& next) {
+  const size_t n = seqan::length(text);
+  // Longer common prefixes only contain motifs longer than maxLength, so the
+  // lcp is capped here as in a truncated index, which bounds the stack.
+  const STSize maxLcp = static_cast<STSize>(maxLength) + 1;
+  // An open lcp interval, with its first suffix, so that the characters of
+  // its motifs can be read from the text.
+  struct Interval {
+    STSize lcp;
+    size_t lb;
+    STSize first;
+  };
+  // The stack of open lcp intervals, with the root interval at the bottom.
+  std::vector<Interval> intervalStack;
+  STSize previousSuffix = 0; // the suffix at i - 1
+  STSize previousLcp = 0; // lcp of the suffix at i - 1 and its predecessor
+  cursor.next(previousSuffix, previousLcp);
+  previousLcp = std::min(previousLcp, maxLcp);
+  intervalStack.push_back(Interval{0, 0, previousSuffix});
+  for (size_t i = 1; i <= n; ++i) {
+    // lcp of the suffixes at i - 1 and i, 0 closes all intervals at the end
+    STSize suffix = 0;
+    STSize lcp = 0;
+    if (i < n) {
+      cursor.next(suffix, lcp);
+      lcp = std::min(lcp, maxLcp);
+    }
+    // the suffix at i - 1 is a leaf, unless it is a prefix of a neighbouring
+    // suffix and therefore ends in an inner node of the suffix tree
+    STSize leafLength = n - previousSuffix;
+    STSize leafParentLength = std::max(previousLcp, lcp);
+    if (leafLength > leafParentLength) {
+      report(text, cursor, i - 1, i - 1, previousSuffix, leafLength, leafParentLength,
+             minLength, maxLength, minFrequency, visit);
+    }
+    // close all intervals that end at i - 1
+    size_t lb = i - 1;
+    STSize first = previousSuffix;
+    while (lcp < intervalStack.back().lcp) {
+      Interval interval = intervalStack.back();
+      intervalStack.pop_back();
+      // the parent is either the next interval on the stack, or the interval
+      // with value lcp that is opened below
+      STSize parentLength = std::max(intervalStack.back().lcp, lcp);
+      report(text, cursor, interval.lb, i - 1, interval.first, interval.lcp, parentLength,
+             minLength, maxLength, minFrequency, visit);
+      lb = interval.lb;
+      first = interval.first;
+    }
+    // open a new interval that contains the closed ones
+    if (lcp > intervalStack.back().lcp) {
+      intervalStack.push_back(Interval{lcp, lb, first});
+    }
+    // all motifs that are not prefixes of the suffix at i are reported now,
+    // so the enumeration can stop here
+    if (i < n && interrupt()) {
+      next = suffix;
+      return false;
+    }
+    previousSuffix = suffix;
+    previousLcp = lcp;
+  }
+  return true;
+}
+
+std::vector<seqan::String<char> > completedBefore(const seqan::String<char>& text,
+                                                   STSize next,
+                                                   const unsigned maxLength) {
+  const size_t n = seqan::length(text);
+  // the characters of the text, in the order of the suffix array
+  std::vector<bool> present(256, false);
+  for (size_t p = 0; p < n; ++p) {
+    present[static_cast<unsigned char>(text[p])] = true;
+  }
+  present[static_cast<unsigned char>(mask::maskCharacter)] = false;
+  std::vector<seqan::String<char> > prefixes;
+  for (size_t j = 0; j < maxLength && next + j < n; ++j) {
+    unsigned char character = text[next + j];
+    // motifs never contain a masked position
+    if (character == static_cast<unsigned char>(mask::maskCharacter)) break;
+    for (unsigned smaller = 0; smaller < character; ++smaller) {
+      if (!present[smaller]) continue;
+      prefixes.push_back(seqan::infix(text, next, next + j));
+      seqan::appendValue(prefixes.back(), static_cast<char>(smaller));
+    }
+  }
+  return prefixes;
+}
+
+template <typename TCursor>
+void report(const seqan::String<char>& text, TCursor& cursor,
+            size_t lb, size_t rb, STSize position,
+            STSize length, STSize parentLength,
+            const unsigned minLength, const unsigned maxLength,
+            const unsigned minFrequency, const Visitor& visit) {
+  STSize frequency = rb - lb + 1;
+  if (frequency < minFrequency) return;
+  // the lengths on the edge that are in range [minLength, maxLength]
+  STSize longest = std::min<STSize>(length, maxLength);
+  STSize shortest = std::max<STSize>(parentLength + 1, minLength);
+  if (longest < shortest) return;
+  // motifs end before the first masked position, which may also lie on an
+  // edge above (e.g. below the interval of the mask character)
+  for (STSize i = 0; i < longest; ++i) {
+    if (text[static_cast<size_t>(position) + i] == mask::maskCharacter) {
+      longest = i;
+      break;
+    }
+  }
+  if (longest < shortest) return;
+  // all motifs of the edge share the same occurrences, which are only read if
+  // the visitor requests them
+  CursorOccurrences<TCursor> occurrences(cursor, lb, rb);
+  // report in postorder, i.e. the longest motif first
+  for (STSize motifLength = longest; motifLength >= shortest; --motifLength) {
+    visit(Motif{text, position, motifLength, frequency, occurrences});
+  }
+}
+}  // anonymous namespace
+
+}  // namespace exact
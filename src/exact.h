@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2017 Jonas Spenger
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+//
+// This is a linear time enumeration of all exact motifs (maximum distance 0)
+// of a sequence. Without mismatches every motif corresponds to a position on
+// an edge of the suffix tree, and its frequency is the size of the lcp
+// interval below that position. The lcp intervals are enumerated bottom-up
+// from the suffix array, and every length in [minLength, maxLength] on the
+// edge leading to an interval is reported.
+//
+// The motifs are reported in the same order as the CAST traversal reports
+// them, i.e. in postorder of the lexicographically ordered search space trie,
+// and the occurrences of each motif are in suffix array order. The characters
+// and the occurrences of a motif are only read if the visitor requests them,
+// so that counting the motifs takes time linear in the number of motifs.
+//
+// For sequences whose index does not fit into memory, the suffix array can be
+// built in prefix partitions on disk (see partition.h) and scanned from there.
+//
+// The enumeration can be interrupted (e.g. at a time limit). It then returns
+// the prefixes whose motifs were all reported, like a stopped CAST traversal
+// (see cast.h).
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "common.h"
+#include "partition.h"
+#include <seqan/index.h>
+#include <functional>
+#include <vector>
+
+namespace exact {
+
+// The occurrences of a motif, they are read from the suffix array on request.
+class Occurrences {
+  public:
+    virtual ~Occurrences() {}
+    // Call visit for every occurrence in suffix array order.
+    virtual void forEach(const std::function<void(STSize)>& visit) const = 0;
+};
+
+// A valid motif, i.e. the prefix of length length of the suffix at position
+// of the text.
+struct Motif {
+  const seqan::String<char>& text;
+  STSize position;
+  unsigned length;
+  STSize frequency;
+  const Occurrences& occurrences;
+};
+
+// Called for every valid motif.
+typedef std::function<void(const Motif& motif)> Visitor;
+
+// Called after every suffix, the enumeration stops if it returns true.
+typedef std::function<bool()> Interrupt;
+
+bool enumerate(STIndex& stIndex,
+               const unsigned minLength,
+               const unsigned maxLength,
+               const unsigned minFrequency,
+               const Visitor& visit,
+               const Interrupt& interrupt,
+               std::vector<seqan::String<char> >& completedPrefixes);
+
+bool enumerate(const seqan::String<char>& text,
+               const std::vector<partition::Partition>& partitions,
+               const unsigned minLength,
+               const unsigned maxLength,
+               const unsigned minFrequency,
+               const Visitor& visit,
+               const Interrupt& interrupt,
+               std::vector<seqan::String<char> >& completedPrefixes);
+
+}  // namespace exact
@@ -24,9 +24,15 @@
 
 
 #include "acme.h"
+#include "output.h"
 #include <seqan/arg_parse.h>
 #include <seqan/basic.h>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include "occurrenceelement.h"
 
 int main(int argc, char const ** argv) {
@@ -108,12 +114,96 @@ int main(int argc, char const ** argv) {
   seqan::setDefaultValue(parser, "maxl", "20");
   seqan::setMinValue(parser, "maxl", "1");
 
+  // The frequency below which branches are verified directly on the text.
+  seqan::addOption(parser, seqan::ArgParseOption(
+    "c", "cutoff", "Frequency below which a motif candidate is verified directly against the sequence (0 disables).",
+    seqan::ArgParseArgument::INTEGER, "INT"));
+  seqan::setDefaultValue(parser, "c", "32");
+  seqan::setMinValue(parser, "c", "0");
+
+  // The memory limit of the index.
+  seqan::addOption(parser, seqan::ArgParseOption(
+    "ml", "mem-limit", "Memory limit of the index in MB, the index is built in partitions on disk and the search keeps "
+    "its occurrences on disk to stay within it (0 disables).",
+    seqan::ArgParseArgument::INTEGER, "INT"));
+  seqan::setDefaultValue(parser, "ml", "0");
+  seqan::setMinValue(parser, "ml", "0");
+
+  // The time limit of the search.
+  seqan::addOption(parser, seqan::ArgParseOption(
+    "tl", "time-limit", "Time limit in seconds, the search stops at it and lists the completed prefixes (0 disables).",
+    seqan::ArgParseArgument::INTEGER, "INT"));
+  seqan::setDefaultValue(parser, "tl", "0");
+  seqan::setMinValue(parser, "tl", "0");
+
+  // The memory limit of the search.
+  seqan::addOption(parser, seqan::ArgParseOption(
+    "sml", "search-mem-limit", "Memory limit of the search in MB, the search stops at it and lists the completed prefixes "
+    "(only with -d > 0, 0 disables).",
+    seqan::ArgParseArgument::INTEGER, "INT"));
+  seqan::setDefaultValue(parser, "sml", "0");
+  seqan::setMinValue(parser, "sml", "0");
+
+  // The prefixes completed by an earlier run.
+  seqan::addOption(parser, seqan::ArgParseOption(
+    "sp", "skip-prefixes", "Comma separated prefixes whose motifs were completed by an earlier run stopped at a limit.",
+    seqan::ArgParseArgument::STRING, "STR"));
+
+  // The directory for the partitions of the index.
+  seqan::addOption(parser, seqan::ArgParseOption(
+    "td", "tmp-dir", "Directory the index partitions and the occurrences are stored in with --mem-limit.",
+    seqan::ArgParseArgument::STRING, "DIR"));
+  seqan::setDefaultValue(parser, "td", ".");
+
+  // Build the index only up to the maximum motif length.
+  seqan::addOption(parser, seqan::ArgParseOption(
+    "tr", "truncate", "Sort the suffix array only up to depth maxlength + 1, which is faster. "
+    "Occurrences sharing more than maxlength characters may be listed in a different order. "
+    "Implied by mem-limit."));
+
+  // The size of the output buffers.
+  seqan::addOption(parser, seqan::ArgParseOption(
+    "ob", "output-buffer", "Output buffer budget in MB, the output is written by a separate thread (0 writes synchronously).",
+    seqan::ArgParseArgument::INTEGER, "INT"));
+  seqan::setDefaultValue(parser, "ob", "16");
+  seqan::setMinValue(parser, "ob", "0");
+
+  // The compression of the output.
+  seqan::addOption(parser, seqan::ArgParseOption(
+    "z", "compress", "Compress the output.", seqan::ArgParseArgument::STRING, "STR"));
+  seqan::setValidValues(parser, "z", "none gzip zstd");
+  seqan::setDefaultValue(parser, "z", "none");
+
+  // The masking of low-complexity regions.
+  seqan::addOption(parser, seqan::ArgParseOption(
+    "dl", "dust", "Mask the repetitive intervals of windows with a DUST score above the given level (20 is common, 0 disables).",
+    seqan::ArgParseArgument::INTEGER, "INT"));
+  seqan::setDefaultValue(parser, "dl", "0");
+  seqan::setMinValue(parser, "dl", "0");
+
+  seqan::addOption(parser, seqan::ArgParseOption(
+    "mb", "mask-bed", "Mask the regions of a BED file (0-based positions in the sequence).",
+    seqan::ArgParseArgument::INPUT_FILE, "FILENAME"));
+  seqan::setValidValues(parser, "mask-bed", "bed");
+
+  // The occurrence cap of a motif.
+  seqan::addOption(parser, seqan::ArgParseOption(
+    "mo", "max-occurrences", "Skip motifs longer than maxdistance (and their extensions) with more occurrences, they are listed in the statistics (0 disables).",
+    seqan::ArgParseArgument::INTEGER, "INT"));
+  seqan::setDefaultValue(parser, "mo", "0");
+  seqan::setMinValue(parser, "mo", "0");
+
   // The mode of what should be output (motif, statistics or silent).
   seqan::addOption(parser, seqan::ArgParseOption(
     "m", "mode", "Select the mode of the output.", seqan::ArgParseArgument::STRING, "STR"));
   seqan::setValidValues(parser, "m", "silent statistics motif");
   seqan::setDefaultValue(parser, "m", "motif");
 
+  // Use the generic traversal, to compare it with the specialized ones.
+  seqan::addOption(parser, seqan::ArgParseOption(
+    "gk", "generic-kernel", "Use the generic instead of the specialized search traversal (for benchmarks)."));
+  seqan::hideOption(parser, "generic-kernel");
+
   // Hide the version-check option in help.
   seqan::hideOption(parser, "version-check");
 
@@ -135,22 +225,53 @@ int main(int argc, char const ** argv) {
 
 
   // Extract option values.
+  ACME::Options options; // the options of the motif discovery
   seqan::CharString filename; // input file name
   seqan::getOptionValue(filename, parser, "input");
-  unsigned frequency = 0; // minimum frequency (no. of occurrence) of approximate matches
-  seqan::getOptionValue(frequency, parser, "frequency");
-  unsigned distance = 0; // maximum hamming distance of approximate matches to motif
-  seqan::getOptionValue(distance, parser, "distance");
-  unsigned minLength = 0; // minimum motif length
-  seqan::getOptionValue(minLength, parser, "minlength");
-  unsigned maxLength = 0; // maximum motif length
-  seqan::getOptionValue(maxLength, parser, "maxlength");
+  seqan::getOptionValue(options.minFrequency, parser, "frequency");
+  seqan::getOptionValue(options.maxDistance, parser, "distance");
+  seqan::getOptionValue(options.minLength, parser, "minlength");
+  seqan::getOptionValue(options.maxLength, parser, "maxlength");
+  seqan::getOptionValue(options.verifyCutoff, parser, "cutoff");
+  unsigned memLimit = 0; // memory limit of the index in MB
+  seqan::getOptionValue(memLimit, parser, "mem-limit");
+  options.memoryLimit = static_cast<size_t>(memLimit) * 1024 * 1024;
+  seqan::CharString tmpDir; // directory of the index partitions
+  seqan::getOptionValue(tmpDir, parser, "tmp-dir");
+  options.tmpDirectory = seqan::toCString(tmpDir);
+  options.truncate = seqan::isSet(parser, "truncate"); // depth-bounded index
+  options.genericKernel = seqan::isSet(parser, "generic-kernel"); // generic traversal
+  unsigned outputBuffer = 0; // output buffer budget in MB
+  seqan::getOptionValue(outputBuffer, parser, "output-buffer");
+  seqan::CharString compression = ""; // compression of the output
+  seqan::getOptionValue(compression, parser, "compress");
+  seqan::getOptionValue(options.dustLevel, parser, "dust");
+  seqan::CharString maskBed; // BED file of masked regions
+  seqan::getOptionValue(maskBed, parser, "mask-bed");
+  seqan::getOptionValue(options.maxOccurrences, parser, "max-occurrences");
+  seqan::getOptionValue(options.timeLimit, parser, "time-limit");
+  unsigned searchMemLimit = 0; // memory limit of the search in MB
+  seqan::getOptionValue(searchMemLimit, parser, "search-mem-limit");
+  options.searchMemoryLimit = static_cast<size_t>(searchMemLimit) * 1024 * 1024;
+  seqan::CharString skipOpt = ""; // prefixes completed by an earlier run
+  seqan::getOptionValue(skipOpt, parser, "skip-prefixes");
+  std::istringstream skipStream(seqan::toCString(skipOpt));
+  for (std::string prefix; std::getline(skipStream, prefix, ',');) {
+    if (!prefix.empty()) options.skipPrefixes.push_back(prefix);
+  }
   seqan::CharString modeOpt = "";
   seqan::getOptionValue(modeOpt, parser, "mode");
-  unsigned mode;
-  if (modeOpt == "silent") mode = 0;
-  if (modeOpt == "statistics") mode = 1;
-  if (modeOpt == "motif") mode = 2;
+  if (modeOpt == "silent") options.mode = 0;
+  if (modeOpt == "statistics") options.mode = 1;
+  if (modeOpt == "motif") options.mode = 2;
+  if (outputBuffer == 0 && compression != "none") {
+    std::cerr << seqan::getAppName(parser) << ": -compress requires an -output-buffer." << "\n";
+    return seqan::ArgumentParser::PARSE_ERROR;
+  }
+  if (options.searchMemoryLimit > 0 && options.maxDistance == 0) {
+    std::cerr << seqan::getAppName(parser) << ": -search-mem-limit is only supported for approximate motifs (-distance > 0)." << "\n";
+    return seqan::ArgumentParser::PARSE_ERROR;
+  }
 
 
   //////////////////////////////////////////////////////////////////////////////
@@ -171,13 +292,54 @@ int main(int argc, char const ** argv) {
     is = &std::cin;
   }
 
+  // Open the BED file of masked regions.
+  std::ifstream bedStream;
+  if (seqan::isSet(parser, "mask-bed")) {
+    bedStream.open(seqan::toCString(maskBed));
+    if (!bedStream.is_open()) {
+      std::cerr << seqan::getAppName(parser) << ": the given path '" << maskBed << "' was not opened." << "\n";
+      return seqan::ArgumentParser::PARSE_ERROR;
+    }
+    options.maskRegions = &bedStream;
+  }
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Set up output
+  //////////////////////////////////////////////////////////////////////////////
+
+  // Write to standard output, through the writer thread of an asynchronous
+  // buffer if an output buffer is set. The buffer budget is split into four
+  // buffers, the remaining output is written when the buffer is destroyed.
+  std::unique_ptr<output::AsyncBuffer> asyncBuffer;
+  std::ostream os(std::cout.rdbuf());
+  if (outputBuffer > 0) {
+    asyncBuffer.reset(new output::AsyncBuffer(
+      std::cout, static_cast<size_t>(outputBuffer) * 1024 * 1024 / 4, 4, seqan::toCString(compression)));
+    os.rdbuf(asyncBuffer.get());
+  }
+
 
   //////////////////////////////////////////////////////////////////////////////
   // Motif discovery.
   //////////////////////////////////////////////////////////////////////////////
 
-  // input stream, output stream, min_length, max_length, min_frequency, max_distance, mode
-  ACME::ACME(*is, std::cout, minLength, maxLength, frequency, distance, mode);
+  // Errors are reported here, so that the output buffered so far is still
+  // written when the buffer is destroyed.
+  try {
+    ACME acme(*is, os, options);
+  } catch (const std::exception& e) {
+    std::cerr << seqan::getAppName(parser) << ": " << e.what() << "\n";
+    return 1;
+  }
+
+  // Fail if the output could not be written completely (e.g. a full disk).
+  os.flush();
+  bool written = asyncBuffer ? asyncBuffer->close() : static_cast<bool>(os);
+  if (!written) {
+    std::cerr << seqan::getAppName(parser) << ": the output could not be written." << "\n";
+    return 1;
+  }
 
   return 0;
 }
@@ -0,0 +1,180 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2017 Jonas Spenger
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "mask.h"
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mask {
+
+// Hide the constants and helper functions in an anonymous namespace so that
+// they cannot be accessed from other files.
+namespace {
+
+// The length of a DUST window.
+const size_t windowLength = 64;
+
+// Replace the positions [begin, end) of seq by the mask character and return
+// the number of newly masked positions.
+STSize maskRange(seqan::String<char>& seq, size_t begin, size_t end);
+
+// Trim the triplets [first, last] with the given sum of a DUST window to the
+// interval with the highest score that keeps last (or first if atStart) and
+// update sum. The counts are those of the trimmed interval afterwards.
+template <typename TTriplet>
+void trim(std::unordered_map<uint32_t, size_t>& counts, TTriplet triplet,
+          size_t& first, size_t& last, size_t& sum, const bool atStart);
+}  // anonymous namespace
+
+
+// Mask the low-complexity intervals of all windows whose DUST score exceeds
+// level.
+// The score of an interval is sum(c_t * (c_t - 1) / 2) / (l - 1) over the
+// counts c_t of all l triplets t in the interval, it is updated incrementally
+// while the window slides over the sequence. A window above level is trimmed
+// at both ends to its interval with the highest score, so that only the
+// repetitive interval is masked and not the flanks of the window.
+// Returns the number of masked positions.
+STSize dust(seqan::String<char>& seq, const unsigned level) {
+  const size_t n = seqan::length(seq);
+  if (level == 0 || n < windowLength) return 0;
+  const unsigned char* s = reinterpret_cast<const unsigned char*>(
+    seqan::begin(seq, seqan::Standard()));
+  const size_t triplets = windowLength - 2; // the number of triplets in a window
+  auto triplet = [s](size_t i) -> uint32_t {
+    return (uint32_t(s[i]) << 16) | (uint32_t(s[i + 1]) << 8) | s[i + 2];
+  };
+
+  // the intervals to mask are collected first, so that masking does not
+  // change the triplets of the following windows
+  std::vector<std::pair<size_t, size_t> > masked;
+  std::unordered_map<uint32_t, size_t> counts;
+  size_t sum = 0; // sum of c_t * (c_t - 1) / 2
+  for (size_t i = 0; i + 2 < n; ++i) {
+    // add the triplet at i, and remove the one that left the window
+    sum += counts[triplet(i)]++;
+    if (i >= triplets) {
+      sum -= --counts[triplet(i - triplets)];
+    }
+    // the window [i + 3 - windowLength, i + 3) is complete
+    if (i + 1 < triplets || sum <= static_cast<size_t>(level) * (triplets - 1)) {
+      continue;
+    }
+    // trim the triplets [first, last] of the window to the interval with
+    // the highest score, first at the end and then at the start of the window
+    size_t first = i + 1 - triplets;
+    size_t last = i;
+    size_t trimmedSum = sum;
+    trim(counts, triplet, first, last, trimmedSum, false);
+    trim(counts, triplet, first, last, trimmedSum, true);
+    // restore the counts of the window
+    for (size_t j = i + 1 - triplets; j < first; ++j) ++counts[triplet(j)];
+    for (size_t j = last + 1; j <= i; ++j) ++counts[triplet(j)];
+    // the masked interval covers the kept triplets
+    if (!masked.empty() && masked.back().second >= first) {
+      masked.back().first = std::min(masked.back().first, first);
+      masked.back().second = std::max(masked.back().second, last + 3);
+    } else {
+      masked.push_back(std::make_pair(first, last + 3));
+    }
+  }
+  STSize count = 0;
+  for (const auto& range : masked) {
+    count += maskRange(seq, range.first, range.second);
+  }
+  return count;
+}
+
+// Mask all regions of a BED file. Header lines (track, browser and comments)
+// are skipped. Returns the number of masked positions.
+STSize regions(seqan::String<char>& seq, std::istream& bed) {
+  STSize count = 0;
+  std::string line;
+  while (std::getline(bed, line)) {
+    if (line.empty() || line[0] == '#' ||
+        line.compare(0, 5, "track") == 0 || line.compare(0, 7, "browser") == 0) {
+      continue;
+    }
+    std::istringstream fields(line);
+    std::string chromosome;
+    size_t begin = 0;
+    size_t end = 0;
+    if (fields >> chromosome >> begin >> end) {
+      count += maskRange(seq, begin, end);
+    }
+  }
+  return count;
+}
+
+namespace {
+
+STSize maskRange(seqan::String<char>& seq, size_t begin, size_t end) {
+  STSize count = 0;
+  end = std::min<size_t>(end, seqan::length(seq));
+  for (size_t i = begin; i < end; ++i) {
+    if (seq[i] != maskCharacter) {
+      seq[i] = maskCharacter;
+      ++count;
+    }
+  }
+  return count;
+}
+
+template <typename TTriplet>
+void trim(std::unordered_map<uint32_t, size_t>& counts, TTriplet triplet,
+          size_t& first, size_t& last, size_t& sum, const bool atStart) {
+  size_t bestFirst = first;
+  size_t bestLast = last;
+  size_t bestSum = sum;
+  // remove one triplet after the other, an interval keeps at least two
+  size_t begin = first;
+  size_t end = last;
+  size_t trimmedSum = sum;
+  while (end - begin > 1) {
+    size_t position = atStart ? begin++ : end--;
+    trimmedSum -= --counts[triplet(position)];
+    // trimmedSum / (end - begin) > bestSum / (bestLast - bestFirst)
+    if (trimmedSum * (bestLast - bestFirst) > bestSum * (end - begin)) {
+      bestFirst = begin;
+      bestLast = end;
+      bestSum = trimmedSum;
+    }
+  }
+  // restore the counts of the triplets between the best and the shortest
+  // interval
+  for (size_t j = bestFirst; j < begin; ++j) ++counts[triplet(j)];
+  for (size_t j = end + 1; j <= bestLast; ++j) ++counts[triplet(j)];
+  first = bestFirst;
+  last = bestLast;
+  sum = bestSum;
+}
+}  // anonymous namespace
+
+}  // namespace mask
@@ -0,0 +1,60 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2017 Jonas Spenger
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+//
+// This is the masking of low-complexity regions (e.g. poly-A runs) before the
+// index is built. Such regions make the number of
+// occurrences of a few prefixes explode for approximate motifs. Masked
+// positions are replaced by maskCharacter, which is not part of the search
+// alphabet, so that no motif occurrence may cover a masked position.
+//
+// Regions are masked either with a DUST-like score over sliding windows:
+//  Morgulis, Aleksandr, et al. "A fast and symmetric DUST implementation to
+//  mask low-complexity DNA sequences." Journal of Computational Biology 13.5
+//  (2006): 1028-1040.
+// where the repetitive interval of a window is masked if its triplets repeat
+// too often. A 64 base window of a homopolymer scores 31, of a dinucleotide
+// repeat 15 and of a trinucleotide repeat 10, so the common level 20 masks
+// homopolymer runs but not microsatellites (they need a lower level).
+// Regions can also be masked from a BED file (start and end are 0-based and
+// half-open, in positions of the concatenated sequence, the chromosome column
+// is ignored).
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "common.h"
+#include <seqan/sequence.h>
+#include <istream>
+
+namespace mask {
+
+// The character masked positions are replaced by.
+const char maskCharacter = '\0';
+
+STSize dust(seqan::String<char>& seq, const unsigned level);
+STSize regions(seqan::String<char>& seq, std::istream& bed);
+
+}  // namespace mask
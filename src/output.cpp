@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2017 Jonas Spenger
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "output.h"
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
+#include <chrono>
+#include <exception>
+#include <ios>
+
+namespace output {
+
+// Hide the constants in an anonymous namespace so that they cannot be
+// accessed from other files.
+namespace {
+
+// The time the threads wait before polling an empty (or full) queue again.
+const std::chrono::microseconds pollInterval(100);
+
+// The end of the filter chain, writes to a std::ostream and throws if it
+// fails, so that a failed write is not lost inside the chain.
+class StreamSink {
+public:
+  typedef char char_type;
+  typedef boost::iostreams::sink_tag category;
+  StreamSink(std::ostream& os) : os(&os) {}
+  std::streamsize write(const char* s, std::streamsize n) {
+    this->os->write(s, n);
+    if (!*this->os) throw std::ios_base::failure("the output stream failed");
+    return n;
+  }
+private:
+  std::ostream* os;
+};
+}  // anonymous namespace
+
+
+// Set up bufferCount buffers of bufferSize characters each, and start the
+// writer thread. compression is one of none, gzip and zstd.
+AsyncBuffer::AsyncBuffer(std::ostream& os,
+                         const size_t bufferSize,
+                         const size_t bufferCount,
+                         const std::string& compression) :
+os(os),
+buffers(std::max<size_t>(bufferCount, 2), std::vector<char>(std::max<size_t>(bufferSize, 1))),
+fullQueue(buffers.size()),
+freeQueue(buffers.size()),
+current(0),
+done(false),
+failed(false),
+closed(false) {
+  if (compression == "gzip") {
+    this->sink.push(boost::iostreams::gzip_compressor());
+  } else if (compression == "zstd") {
+    this->sink.push(boost::iostreams::zstd_compressor());
+  }
+  this->sink.push(StreamSink(this->os));
+  // the first buffer is filled, all others are free
+  for (size_t i = 1; i < this->buffers.size(); ++i) {
+    this->freeQueue.push(i);
+  }
+  std::vector<char>& buffer = this->buffers[this->current];
+  this->setp(buffer.data(), buffer.data() + buffer.size());
+  this->writer = std::thread(&AsyncBuffer::write, this);
+}
+
+// Close the stream if it was not closed explicitly.
+AsyncBuffer::~AsyncBuffer() {
+  AsyncBuffer::close();
+}
+
+// Hand off the last buffer, wait for the writer thread to write everything
+// and close the (compressed) stream. Returns false if any write failed.
+bool AsyncBuffer::close() {
+  if (!this->closed) {
+    this->closed = true;
+    AsyncBuffer::handOff();
+    this->done.store(true, std::memory_order_release);
+    this->writer.join();
+    try {
+      // writes the end of the compressed stream
+      this->sink.reset();
+    } catch (const std::exception&) {
+      this->failed.store(true);
+    }
+    this->os.flush();
+    if (!this->os) this->failed.store(true);
+  }
+  return !this->failed.load();
+}
+
+// Called if the current buffer is full, hand it off and continue with a free
+// one.
+AsyncBuffer::int_type AsyncBuffer::overflow(int_type c) {
+  AsyncBuffer::handOff();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *this->pptr() = traits_type::to_char_type(c);
+    this->pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+// Called on flush, hand off the current buffer without waiting for it to be
+// written.
+int AsyncBuffer::sync() {
+  AsyncBuffer::handOff();
+  return 0;
+}
+
+// Push the current buffer to the writer thread, and take a free buffer. This
+// only waits if all buffers are waiting to be written.
+void AsyncBuffer::handOff() {
+  size_t size = this->pptr() - this->pbase();
+  if (size == 0) return;
+  // there are never more chunks than buffers, so the push always succeeds
+  this->fullQueue.push(Chunk{this->current, size});
+  while (!this->freeQueue.pop(this->current)) {
+    std::this_thread::sleep_for(pollInterval);
+  }
+  std::vector<char>& buffer = this->buffers[this->current];
+  this->setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+// The writer thread, write full buffers to the sink and return them to the
+// free buffers until done.
+void AsyncBuffer::write() {
+  while (true) {
+    // read done before polling, so that no chunk pushed before done is missed
+    bool finished = this->done.load(std::memory_order_acquire);
+    Chunk chunk;
+    if (this->fullQueue.pop(chunk)) {
+      // after a failure the output is incomplete anyway, so it is discarded
+      if (!this->failed.load()) {
+        try {
+          this->sink.write(this->buffers[chunk.index].data(), chunk.size);
+          if (!this->sink) this->failed.store(true);
+        } catch (const std::exception&) {
+          this->failed.store(true);
+        }
+      }
+      this->freeQueue.push(chunk.index);
+    } else if (finished) {
+      return;
+    } else {
+      std::this_thread::sleep_for(pollInterval);
+    }
+  }
+}
+
+}  // namespace output
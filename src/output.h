@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2017 Jonas Spenger
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+//
+// This is an asynchronous output stage. The output is collected in large
+// buffers through a std::streambuf, so that it can be used by any
+// std::ostream, and every full buffer is handed to a writer thread through a
+// lock-free queue. The writer thread writes the buffers to the underlying
+// stream, optionally compressed (gzip or zstd) with Boost.Iostreams.
+//
+// The buffers are recycled through a second lock-free queue, so the thread
+// producing the output only waits for the writer thread if all buffers are
+// full, i.e. if the buffer budget is exhausted.
+//
+// A failed write (e.g. a full disk) is recorded by the writer thread, the
+// remaining output is discarded and close() reports the failure.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <atomic>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace output {
+
+class AsyncBuffer : public std::streambuf {
+public:
+  AsyncBuffer(std::ostream& os,
+              const size_t bufferSize,
+              const size_t bufferCount,
+              const std::string& compression);
+  ~AsyncBuffer();
+  bool close();
+protected:
+  int_type overflow(int_type c);
+  int sync();
+private:
+  // A full buffer: its index and the number of characters in it.
+  struct Chunk {
+    size_t index;
+    size_t size;
+  };
+  std::ostream& os;
+  boost::iostreams::filtering_ostream sink;
+  std::vector<std::vector<char> > buffers;
+  boost::lockfree::spsc_queue<Chunk> fullQueue; // buffers to be written
+  boost::lockfree::spsc_queue<size_t> freeQueue; // buffers that can be filled
+  size_t current; // the buffer that is currently filled
+  std::atomic<bool> done;
+  std::atomic<bool> failed; // a write to the sink failed
+  bool closed;
+  std::thread writer;
+  void handOff();
+  void write();
+};
+
+}  // namespace output
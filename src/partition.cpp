@@ -0,0 +1,373 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2017 Jonas Spenger
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "partition.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <unistd.h>
+#include <utility>
+
+namespace partition {
+
+// Hide the helper functions in an anonymous namespace so that they cannot be
+// accessed from other files.
+namespace {
+
+// The number of entries that are read from or written to disk at once.
+const size_t bufferSize = 1 << 16;
+
+// The smallest suffix of a partition: the first suffix starting with prefix
+// (at most depth characters) at or after position.
+struct Bound {
+  std::string prefix;
+  STSize position;
+};
+
+// Split the suffixes of text by their prefixes (up to depth), and by their
+// positions if they share their first depth characters, into ordered groups
+// of at most maxSize suffixes, and return the smallest suffix of each.
+std::vector<Bound> splitPrefixes(const char* text, size_t n, size_t depth, size_t maxSize);
+
+// Check if the suffix of text at position is smaller than bound, comparing
+// at most depth characters.
+bool suffixLess(const char* text, size_t n, size_t depth, size_t position, const Bound& bound);
+
+// Check if the suffix of text at a is smaller than the one at b, comparing at
+// most depth characters and then the positions.
+bool suffixLess(const char* text, size_t n, size_t depth, size_t a, size_t b);
+
+// The length of the longest common prefix of the suffixes at a and b, at most
+// depth.
+STSize lcp(const char* text, size_t n, size_t depth, size_t a, size_t b);
+
+// Open the partition at index for sequential reading.
+void open(Cursor& cursor, size_t index);
+
+// Throw an error if a partition file cannot be accessed.
+void fail(const std::string& path);
+}  // anonymous namespace
+
+
+// Build the suffix array partitions of text in directory, such that each
+// partition holds at most memoryLimit bytes of suffixes. The suffixes are
+// compared up to depth characters.
+// Every partition is collected with a scan over the text, sorted in memory and
+// written to disk together with the lcp of each suffix and its predecessor.
+// If a file cannot be written, the files written so far are deleted.
+std::vector<Partition> build(const seqan::String<char>& text,
+                             const std::string& directory,
+                             const size_t memoryLimit,
+                             const unsigned depth) {
+  const char* t = seqan::begin(text, seqan::Standard());
+  const size_t n = seqan::length(text);
+  std::vector<Partition> partitions;
+  if (n == 0) return partitions;
+
+  // the number of suffixes that fit into the memory limit
+  const size_t maxSize = std::max<size_t>(memoryLimit / sizeof(STSize), 1);
+  std::vector<Bound> lowerBounds = splitPrefixes(t, n, depth, maxSize);
+
+  const std::string path = directory + "/acme_" + std::to_string(getpid()) + "_";
+  size_t previous = n; // the last suffix of the previous partition, n if none
+  try {
+    for (size_t k = 0; k < lowerBounds.size(); ++k) {
+      // collect the suffixes between the lower bound of this partition and the
+      // lower bound of the next partition
+      std::vector<STSize> suffixes;
+      for (size_t p = 0; p < n; ++p) {
+        if (!suffixLess(t, n, depth, p, lowerBounds[k]) &&
+            (k + 1 == lowerBounds.size() || suffixLess(t, n, depth, p, lowerBounds[k + 1]))) {
+          suffixes.push_back(p);
+        }
+      }
+      std::sort(suffixes.begin(), suffixes.end(), [t, n, depth](STSize a, STSize b) {
+        return suffixLess(t, n, depth, a, b);
+      });
+
+      partitions.push_back(Partition{
+        path + std::to_string(k) + ".sa",
+        path + std::to_string(k) + ".lcp",
+        static_cast<STSize>(suffixes.size())
+      });
+      const Partition& partition = partitions.back();
+      std::ofstream saStream(partition.saPath, std::ios::binary);
+      std::ofstream lcpStream(partition.lcpPath, std::ios::binary);
+      saStream.write(reinterpret_cast<const char*>(suffixes.data()),
+                     suffixes.size() * sizeof(STSize));
+      // the lcp is computed while writing, so that it needs no array of its own
+      std::vector<STSize> lcpBuffer;
+      lcpBuffer.reserve(bufferSize);
+      for (STSize suffix : suffixes) {
+        lcpBuffer.push_back(previous == n ? 0 : lcp(t, n, depth, previous, suffix));
+        previous = suffix;
+        if (lcpBuffer.size() == bufferSize) {
+          lcpStream.write(reinterpret_cast<const char*>(lcpBuffer.data()),
+                          lcpBuffer.size() * sizeof(STSize));
+          lcpBuffer.clear();
+        }
+      }
+      lcpStream.write(reinterpret_cast<const char*>(lcpBuffer.data()),
+                      lcpBuffer.size() * sizeof(STSize));
+      if (!saStream) fail(partition.saPath);
+      if (!lcpStream) fail(partition.lcpPath);
+    }
+  } catch (...) {
+    remove(partitions);
+    throw;
+  }
+  return partitions;
+}
+
+// Delete the files of all partitions.
+void remove(const std::vector<Partition>& partitions) {
+  for (const Partition& partition : partitions) {
+    std::remove(partition.saPath.c_str());
+    std::remove(partition.lcpPath.c_str());
+  }
+}
+
+// A sequential reader over the suffix array and the lcp array of all
+// partitions, starting at the first partition.
+Cursor::Cursor(const std::vector<Partition>& partitions) :
+partitions(partitions), partitionIndex(0), remaining(0), bufferIndex(0),
+bufferStart(0), randomIndex(partitions.size()) {
+  STSize offset = 0;
+  for (const Partition& partition : partitions) {
+    this->offsets.push_back(offset);
+    offset += partition.size;
+  }
+  if (!partitions.empty()) {
+    open(*this, 0);
+  }
+}
+
+// Read the next suffix of the suffix array and its lcp with the preceding
+// suffix. The entries are buffered, so that the partitions are read
+// sequentially in large blocks.
+void next(Cursor& cursor, STSize& suffix, STSize& lcp) {
+  if (cursor.bufferIndex == cursor.saBuffer.size()) {
+    // move on to the next partition if the current one is read completely
+    while (cursor.remaining == 0) {
+      open(cursor, cursor.partitionIndex + 1);
+    }
+    const Partition& partition = cursor.partitions[cursor.partitionIndex];
+    size_t size = std::min<size_t>(cursor.remaining, bufferSize);
+    cursor.bufferStart = cursor.offsets[cursor.partitionIndex] + partition.size - cursor.remaining;
+    cursor.saBuffer.resize(size);
+    cursor.lcpBuffer.resize(size);
+    cursor.saStream.read(reinterpret_cast<char*>(cursor.saBuffer.data()), size * sizeof(STSize));
+    cursor.lcpStream.read(reinterpret_cast<char*>(cursor.lcpBuffer.data()), size * sizeof(STSize));
+    if (!cursor.saStream) fail(partition.saPath);
+    if (!cursor.lcpStream) fail(partition.lcpPath);
+    cursor.remaining -= size;
+    cursor.bufferIndex = 0;
+  }
+  suffix = cursor.saBuffer[cursor.bufferIndex];
+  lcp = cursor.lcpBuffer[cursor.bufferIndex];
+  ++cursor.bufferIndex;
+}
+
+// Visit the suffixes at positions [lb, rb] of the suffix array in order.
+// Ranges inside the sequential buffer are read from there, all others are
+// read from the partition files in blocks, so that a large range is never
+// held in memory.
+void forEachSuffix(Cursor& cursor, size_t lb, size_t rb,
+                   const std::function<void(STSize)>& visit) {
+  if (lb >= cursor.bufferStart && rb < cursor.bufferStart + cursor.saBuffer.size()) {
+    for (size_t i = lb; i <= rb; ++i) {
+      visit(cursor.saBuffer[i - cursor.bufferStart]);
+    }
+    return;
+  }
+  // the partition containing lb
+  size_t k = std::upper_bound(cursor.offsets.begin(), cursor.offsets.end(), lb) - cursor.offsets.begin() - 1;
+  std::vector<STSize> block;
+  size_t i = lb;
+  while (i <= rb) {
+    const Partition& partition = cursor.partitions[k];
+    if (cursor.randomIndex != k) {
+      cursor.randomStream.close();
+      cursor.randomStream.clear();
+      cursor.randomStream.open(partition.saPath, std::ios::binary);
+      cursor.randomIndex = k;
+    }
+    size_t end = std::min<size_t>(rb + 1, cursor.offsets[k] + partition.size);
+    cursor.randomStream.seekg((i - cursor.offsets[k]) * sizeof(STSize));
+    while (i < end) {
+      block.resize(std::min<size_t>(end - i, bufferSize));
+      cursor.randomStream.read(reinterpret_cast<char*>(block.data()), block.size() * sizeof(STSize));
+      if (!cursor.randomStream) fail(partition.saPath);
+      for (STSize suffix : block) {
+        visit(suffix);
+      }
+      i += block.size();
+    }
+    ++k;
+  }
+}
+
+namespace {
+
+std::vector<Bound> splitPrefixes(const char* text, size_t n, size_t depth, size_t maxSize) {
+  // The prefixes (with their number of suffixes) in lexicographic order.
+  // An oversized prefix is refined to the prefixes one character longer, and
+  // to the prefix itself if one suffix equals it (it is smaller than all
+  // others), until every prefix fits or is depth long.
+  std::vector<std::pair<std::string, STSize> > prefixes;
+  prefixes.push_back(std::make_pair(std::string(), static_cast<STSize>(n)));
+  for (size_t length = 0; length < depth; ++length) {
+    std::set<std::string> oversized;
+    for (const auto& prefix : prefixes) {
+      if (prefix.second > maxSize && prefix.first.size() == length) {
+        oversized.insert(prefix.first);
+      }
+    }
+    if (oversized.empty()) break;
+    // count the suffixes of all oversized prefixes by their next character
+    std::map<std::string, STSize> counts;
+    std::string key;
+    for (size_t p = 0; p < n && p + length <= n; ++p) {
+      key.assign(text + p, length);
+      if (oversized.count(key) == 0) continue;
+      if (p + length < n) {
+        key.push_back(text[p + length]);
+      }
+      counts[key] += 1;
+    }
+    std::vector<std::pair<std::string, STSize> > refined;
+    for (const auto& prefix : prefixes) {
+      if (oversized.count(prefix.first) == 0) {
+        refined.push_back(prefix);
+        continue;
+      }
+      for (auto it = counts.lower_bound(prefix.first);
+           it != counts.end() && it->first.compare(0, length, prefix.first) == 0; ++it) {
+        refined.push_back(*it);
+      }
+    }
+    prefixes.swap(refined);
+  }
+
+  // The suffixes of a prefix that is still oversized share their first depth
+  // characters and are ordered by position, so they are split into chunks of
+  // maxSize suffixes at the positions collected here.
+  std::map<std::string, std::vector<STSize> > chunkStarts;
+  for (const auto& prefix : prefixes) {
+    if (prefix.second > maxSize) {
+      chunkStarts[prefix.first];
+    }
+  }
+  if (!chunkStarts.empty()) {
+    std::map<std::string, STSize> counts;
+    std::string key;
+    for (size_t p = 0; p + depth <= n; ++p) {
+      key.assign(text + p, depth);
+      auto chunk = chunkStarts.find(key);
+      if (chunk == chunkStarts.end()) continue;
+      STSize& count = counts[key];
+      if (count > 0 && count % maxSize == 0) {
+        chunk->second.push_back(p);
+      }
+      ++count;
+    }
+  }
+
+  // group adjacent prefixes (and chunks) into partitions of at most maxSize
+  // suffixes
+  std::vector<Bound> lowerBounds;
+  size_t size = 0;
+  auto add = [&lowerBounds, &size, maxSize](const Bound& bound, size_t count) {
+    if (lowerBounds.empty() || size + count > maxSize) {
+      lowerBounds.push_back(bound);
+      size = 0;
+    }
+    size += count;
+  };
+  for (const auto& prefix : prefixes) {
+    if (prefix.second <= maxSize) {
+      add(Bound{prefix.first, 0}, prefix.second);
+      continue;
+    }
+    const std::vector<STSize>& starts = chunkStarts[prefix.first];
+    add(Bound{prefix.first, 0}, maxSize);
+    for (size_t i = 0; i < starts.size(); ++i) {
+      add(Bound{prefix.first, starts[i]},
+          i + 1 < starts.size() ? maxSize : prefix.second - maxSize * starts.size());
+    }
+  }
+  return lowerBounds;
+}
+
+bool suffixLess(const char* text, size_t n, size_t depth, size_t position, const Bound& bound) {
+  size_t length = std::min(n - position, depth);
+  size_t common = std::min(length, bound.prefix.size());
+  int comparison = std::memcmp(text + position, bound.prefix.data(), common);
+  if (comparison != 0) return comparison < 0;
+  if (length != bound.prefix.size()) return length < bound.prefix.size();
+  return position < bound.position;
+}
+
+bool suffixLess(const char* text, size_t n, size_t depth, size_t a, size_t b) {
+  size_t lengthA = std::min(n - a, depth);
+  size_t lengthB = std::min(n - b, depth);
+  int comparison = std::memcmp(text + a, text + b, std::min(lengthA, lengthB));
+  if (comparison != 0) return comparison < 0;
+  if (lengthA != lengthB) return lengthA < lengthB; // a prefix of the other
+  return a < b;
+}
+
+STSize lcp(const char* text, size_t n, size_t depth, size_t a, size_t b) {
+  STSize length = 0;
+  while (length < depth && a + length < n && b + length < n && text[a + length] == text[b + length]) {
+    ++length;
+  }
+  return length;
+}
+
+void open(Cursor& cursor, size_t index) {
+  const Partition& partition = cursor.partitions[index];
+  cursor.saStream.close();
+  cursor.saStream.clear();
+  cursor.lcpStream.close();
+  cursor.lcpStream.clear();
+  cursor.saStream.open(partition.saPath, std::ios::binary);
+  cursor.lcpStream.open(partition.lcpPath, std::ios::binary);
+  if (!cursor.saStream) fail(partition.saPath);
+  if (!cursor.lcpStream) fail(partition.lcpPath);
+  cursor.partitionIndex = index;
+  cursor.remaining = partition.size;
+}
+
+void fail(const std::string& path) {
+  throw std::runtime_error("could not access the partition file '" + path + "'.");
+}
+}  // anonymous namespace
+
+}  // namespace partition
@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2017 Jonas Spenger
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+//
+// This is an external memory construction of the suffix array and lcp array
+// of a sequence, similar to the vertical partitioning of ERA as used by the
+// ACME authors:
+//  Mansour, Essam, et al. "ERA: efficient serial and parallel suffix tree
+//  construction for very long strings." Proceedings of the VLDB Endowment
+//  5.1 (2011): 49-60.
+//
+// The suffixes are split by their prefixes into partitions, such that the
+// suffix array of every partition fits into the given memory limit. The
+// partitions are lexicographically ordered, each one is sorted in memory and
+// written to disk, so that the concatenation of all partitions is the suffix
+// array of the whole sequence. Only the sequence itself and one partition are
+// held in memory at a time.
+//
+// As in truncated.h, the suffixes are only compared up to a given depth, and
+// suffixes with the same first depth characters are ordered by position. The
+// lcp is at most depth. This bounds the time of a comparison on repeats, and
+// suffixes sharing their first depth characters (e.g. in a long poly-A run)
+// can be split by position into several partitions, so that no partition
+// exceeds the memory limit.
+//
+// The partitions can be read sequentially with a cursor through the methods:
+//  next()
+//  forEachSuffix()
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "common.h"
+#include <seqan/sequence.h>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace partition {
+
+// A partition of the suffix array stored on disk, the file at saPath holds
+// the suffixes and the file at lcpPath the lcp of every suffix with its
+// predecessor in the suffix array of the whole sequence.
+struct Partition {
+  std::string saPath;
+  std::string lcpPath;
+  STSize size;
+};
+
+// A sequential reader over all partitions.
+struct Cursor {
+  public:
+    Cursor(const std::vector<Partition>& partitions);
+    const std::vector<Partition>& partitions;
+    size_t partitionIndex; // the partition that is currently read
+    STSize remaining; // entries of the current partition not yet buffered
+    std::ifstream saStream;
+    std::ifstream lcpStream;
+    std::vector<STSize> saBuffer;
+    std::vector<STSize> lcpBuffer;
+    size_t bufferIndex; // the next entry of the buffers
+    STSize bufferStart; // position of the buffers in the suffix array
+    std::vector<STSize> offsets; // position of each partition in the suffix array
+    size_t randomIndex; // the partition opened for random access
+    std::ifstream randomStream;
+};
+
+std::vector<Partition> build(const seqan::String<char>& text,
+                             const std::string& directory,
+                             const size_t memoryLimit,
+                             const unsigned depth);
+void remove(const std::vector<Partition>& partitions);
+void next(Cursor& cursor, STSize& suffix, STSize& lcp);
+void forEachSuffix(Cursor& cursor, size_t lb, size_t rb,
+                   const std::function<void(STSize)>& visit);
+
+}  // namespace partition
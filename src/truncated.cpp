@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2017 Jonas Spenger
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "truncated.h"
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace truncated {
+
+// Hide the helpers in an anonymous namespace so that they cannot be accessed
+// from other files.
+namespace {
+
+// Buckets of at most this many suffixes are sorted by insertion sort instead
+// of another radix pass.
+const size_t smallBucket = 16;
+
+// A bucket of suffixes sa[lb, rb) that share their first d characters.
+// boundary is the lcp of the last suffix of the bucket and the first suffix
+// of the next bucket, it is written once the bucket is sorted.
+struct Bucket {
+  size_t lb;
+  size_t rb;
+  size_t d;
+  STSize boundary;
+};
+}  // anonymous namespace
+
+// Build the suffix array and the lcp table of stIndex up to depth.
+// The suffixes are sorted by a stable most significant digit radix sort over
+// their first depth characters, the end of the sequence is smaller than every
+// character, and suffixes that share them are kept in text order. The radix
+// sort only refines buckets that still hold more than one suffix, and small
+// buckets are finished by insertion sort, so most suffixes are placed after
+// a few passes instead of depth passes.
+// The suffix array is sorted in place, and the lcp table (which is written
+// bucket by bucket) serves as the buffer of the radix passes, so no memory
+// beyond the two fibres is needed. lcp[i] is the longest common prefix of
+// the suffixes at i and i + 1, at most depth.
+void createIndex(STIndex& stIndex, const unsigned depth) {
+  const seqan::String<char>& text = seqan::indexText(stIndex);
+  const unsigned char* t = reinterpret_cast<const unsigned char*>(
+    seqan::begin(text, seqan::Standard()));
+  const size_t n = seqan::length(text);
+
+  // the radix of a suffix at offset d, 0 marks the end of the sequence
+  auto radix = [t, n](size_t suffix, size_t d) -> size_t {
+    return suffix + d < n ? t[suffix + d] + 1 : 0;
+  };
+
+  auto& sa = seqan::indexSA(stIndex);
+  auto& lcp = seqan::indexLcp(stIndex);
+  seqan::resize(sa, n);
+  seqan::resize(lcp, n);
+  for (size_t i = 0; i < n; ++i) {
+    sa[i] = i;
+  }
+  if (n == 0) return;
+
+  // every bucket writes lcp[lb, rb - 1) and its boundary at lcp[rb - 1] once
+  // it is sorted, until then lcp[lb, rb) is free to hold its suffixes
+  std::vector<Bucket> buckets;
+  buckets.push_back(Bucket{0, n, 0, 0});
+  std::array<size_t, 257> counts;
+  while (!buckets.empty()) {
+    const Bucket bucket = buckets.back();
+    buckets.pop_back();
+    const size_t size = bucket.rb - bucket.lb;
+    if (size > smallBucket && bucket.d < depth) {
+      // distribute the suffixes by their character at d through the lcp
+      // table, and push the new buckets
+      counts.fill(0);
+      for (size_t i = bucket.lb; i < bucket.rb; ++i) {
+        ++counts[radix(sa[i], bucket.d)];
+      }
+      size_t position = bucket.lb;
+      for (size_t& count : counts) {
+        size_t next = position + count;
+        count = position;
+        position = next;
+      }
+      for (size_t i = bucket.lb; i < bucket.rb; ++i) {
+        lcp[counts[radix(sa[i], bucket.d)]++] = sa[i];
+      }
+      size_t lb = bucket.lb;
+      for (size_t count : counts) {
+        if (count == lb) continue;
+        for (size_t i = lb; i < count; ++i) {
+          sa[i] = lcp[i];
+        }
+        // suffixes in different buckets share exactly d characters
+        buckets.push_back(Bucket{lb, count, bucket.d + 1,
+                                 count == bucket.rb ? bucket.boundary : static_cast<STSize>(bucket.d)});
+        lb = count;
+      }
+      continue;
+    }
+    // sort a small bucket (or one at depth, which is sorted already) by
+    // insertion sort, which is stable, and compare neighbours for the lcp
+    auto sharedLength = [&](size_t a, size_t b) -> size_t {
+      size_t length = bucket.d;
+      while (length < depth && a + length < n && b + length < n && t[a + length] == t[b + length]) {
+        ++length;
+      }
+      return length;
+    };
+    for (size_t i = bucket.lb + 1; i < bucket.rb && bucket.d < depth; ++i) {
+      const STSize suffix = sa[i];
+      size_t j = i;
+      for (; j > bucket.lb; --j) {
+        const size_t length = sharedLength(sa[j - 1], suffix);
+        if (length == depth || radix(sa[j - 1], length) <= radix(suffix, length)) break;
+        sa[j] = sa[j - 1];
+      }
+      sa[j] = suffix;
+    }
+    for (size_t i = bucket.lb; i + 1 < bucket.rb; ++i) {
+      lcp[i] = bucket.d < depth ? sharedLength(sa[i], sa[i + 1]) : depth;
+    }
+    lcp[bucket.rb - 1] = bucket.boundary;
+  }
+}
+
+}  // namespace truncated
@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////////////////////////////
+// MIT License
+//
+// Copyright (c) 2017 Jonas Spenger
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+//
+// This is the construction of a depth-bounded (truncated) enhanced suffix
+// array. Motifs are at most maxLength long, so the search never looks deeper
+// than maxLength + 1 characters into the suffix tree. The suffixes are
+// therefore only sorted by their first depth characters (suffixes that share
+// them are kept in text order), and the lcp table is capped at depth.
+// Both are stored as the suffix array and lcp table of a regular STIndex, so
+// that the suffix tree iterators (and thus the CAST traversal) work on top of
+// it unchanged: the suffix tree is exact up to depth, and every deeper suffix
+// is a leaf below its node at depth.
+//
+// Sorting is a radix sort over the first depth characters that works in
+// place on the suffix array and uses the lcp table as its buffer, so the
+// construction needs no memory beyond the index itself. The CAST search reads
+// the frequency and length of a node from the index, so the memory of a
+// search stays linear in the length of the sequence.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include "common.h"
+#include <seqan/index.h>
+
+namespace truncated {
+
+void createIndex(STIndex& stIndex, const unsigned depth);
+
+}  // namespace truncated
@@ -4,4 +4,40 @@ build/ACME -i test/test_sequence.txt -f 2 -d 0 | grep -a -v '^#' | cmp test/test
 build/ACME -i test/test_sequence.txt -f 2 -d 1 | grep -a -v '^#' | cmp test/test_sequence_f_2_d_1.answer;
 build/ACME -i test/test_sequence.txt -f 3 -d 2 | grep -a -v '^#' | cmp test/test_sequence_f_3_d_2.answer;
 build/ACME -i test/test_sequence.txt -f 5 -d 0 | grep -a -v '^#' | cmp test/test_sequence_f_5_d_0.answer;
+# same answers without direct verification of sparse branches
+build/ACME -i test/test_sequence.txt -f 2 -d 1 -c 0 | grep -a -v '^#' | cmp test/test_sequence_f_2_d_1.answer;
+build/ACME -i test/test_sequence.txt -f 3 -d 2 -c 0 | grep -a -v '^#' | cmp test/test_sequence_f_3_d_2.answer;
+# same answers with the index built in partitions on disk
+build/ACME -i test/test_sequence.txt -f 2 -d 0 -ml 1 | grep -a -v '^#' | cmp test/test_sequence_f_2_d_0.answer;
+build/ACME -i test/test_sequence.txt -f 2 -d 1 -ml 1 -td build | grep -a -v '^#' | cmp test/test_sequence_f_2_d_1.answer;
+build/ACME -i test/test_sequence.txt -f 3 -d 2 -ml 1 -td build | grep -a -v '^#' | cmp test/test_sequence_f_3_d_2.answer;
+# same answers from many partitions, with a poly-A run that is split by position
+awk 'BEGIN { srand(2); for (i = 0; i < 1000000; ++i) printf "%s", (i >= 500000 && i < 520000) ? "A" : substr("ACGT", int(rand() * 4) + 1, 1); print "" }' > build/partition_sequence.txt;
+build/ACME -i build/partition_sequence.txt -f 2 -d 0 -minl 3 -maxl 3 -tr | grep -a -v '^#' > build/partition_sequence.answer;
+build/ACME -i build/partition_sequence.txt -f 2 -d 0 -minl 3 -maxl 3 -ml 1 -td build | grep -a -v '^#' | cmp build/partition_sequence.answer;
+# same answers with the index truncated at the maximum motif length
+build/ACME -i test/test_sequence.txt -f 2 -d 0 -tr | grep -a -v '^#' | cmp test/test_sequence_f_2_d_0.answer;
+build/ACME -i test/test_sequence.txt -f 2 -d 1 -tr | grep -a -v '^#' | cmp test/test_sequence_f_2_d_1.answer;
+# same answers written synchronously and compressed
+build/ACME -i test/test_sequence.txt -f 2 -d 1 -ob 0 | grep -a -v '^#' | cmp test/test_sequence_f_2_d_1.answer;
+build/ACME -i test/test_sequence.txt -f 2 -d 1 -z gzip | gunzip | grep -a -v '^#' | cmp test/test_sequence_f_2_d_1.answer;
+build/ACME -i test/test_sequence.txt -f 2 -d 1 -z zstd | zstd -d | grep -a -v '^#' | cmp test/test_sequence_f_2_d_1.answer;
+# same answers with masking and the occurrence cap disabled
+build/ACME -i test/test_sequence.txt -f 2 -d 1 -dl 0 -mo 0 | grep -a -v '^#' | cmp test/test_sequence_f_2_d_1.answer;
+# a poly-A run masked by DUST, regions masked from a BED file, and prefixes
+# skipped by the occurrence cap
+build/ACME -i test/test_sequence_polya.txt -f 2 -d 1 -dl 20 | cmp test/test_sequence_polya_f_2_d_1_dl_20.answer;
+build/ACME -i test/test_sequence.txt -f 2 -d 1 -mb test/test_sequence.bed | cmp test/test_sequence_f_2_d_1_mb.answer;
+build/ACME -i test/test_sequence_polya.txt -f 2 -d 0 -dl 20 | cmp test/test_sequence_polya_f_2_d_0_dl_20.answer;
+build/ACME -i test/test_sequence.txt -f 2 -d 0 -mb test/test_sequence.bed | cmp test/test_sequence_f_2_d_0_mb.answer;
+build/ACME -i test/test_sequence.txt -f 2 -d 0 -mb test/test_sequence.bed -ml 1 -td build | cmp test/test_sequence_f_2_d_0_mb.answer;
+build/ACME -i test/test_sequence.txt -f 2 -d 1 -mo 20 | cmp test/test_sequence_f_2_d_1_mo_20.answer;
+build/ACME -i test/test_sequence.txt -f 2 -d 0 -mo 12 | cmp test/test_sequence_f_2_d_0_mo_12.answer;
+build/ACME -i test/test_sequence.txt -f 2 -d 0 -mo 12 -ml 1 -td build | cmp test/test_sequence_f_2_d_0_mo_12.answer;
+# same answers with limits that are not reached
+build/ACME -i test/test_sequence.txt -f 2 -d 1 -tl 3600 -sml 4096 | grep -a -v '^#' | cmp test/test_sequence_f_2_d_1.answer;
+build/ACME -i test/test_sequence.txt -f 2 -d 0 -tl 3600 | grep -a -v '^#' | cmp test/test_sequence_f_2_d_0.answer;
+# same answers from a run resumed with the prefixes completed by another run
+(build/ACME -i test/test_sequence.txt -f 2 -d 1 -sp C,G,T; build/ACME -i test/test_sequence.txt -f 2 -d 1 -sp A) | grep -a -v '^#' | cmp test/test_sequence_f_2_d_1.answer;
+(build/ACME -i test/test_sequence.txt -f 2 -d 0 -sp C,G,T; build/ACME -i test/test_sequence.txt -f 2 -d 0 -sp A) | grep -a -v '^#' | cmp test/test_sequence_f_2_d_0.answer;
 echo "test completed";
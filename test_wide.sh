@@ -0,0 +1,28 @@
+# check the 64-bit position build on a sequence of more than 2^32 characters
+# (about 80 GB of memory and 20 GB of disk, it is not part of test.sh).
+# Two copies of a marker are separated by a long masked filler. The motifs
+# must equal those of the same sequence with a short filler, with the
+# positions behind the filler shifted by the difference.
+filler=${WIDE_FILLER:-4294967296};
+marker=CGTCGTCGTCGC;
+mkdir -p build_wide;
+(cd build_wide && cmake -DCMAKE_BUILD_TYPE=Release -DACME_WIDE_POSITIONS=ON .. && make) || exit 1;
+echo "starting wide test";
+# write the sequence and the BED file of the filler for a filler length
+sequence() {
+  { head -c 1000 /dev/zero | tr '\0' A; printf $marker;
+    head -c $1 /dev/zero | tr '\0' A; printf $marker;
+    head -c 1000 /dev/zero | tr '\0' A; echo; } > build_wide/wide_$1.txt;
+  printf 'wide\t0\t1000\nwide\t1012\t%s\nwide\t%s\t%s\n' $((1012 + $1)) $((1024 + $1)) $((2024 + $1)) > build_wide/wide_$1.bed;
+}
+sequence 1000;
+sequence $filler;
+# shift the positions behind the short filler
+shiftPositions() {
+  awk -v delta=$(($filler - 1000)) '{ printf "%s %s [", $1, $2; for (i = 4; i < NF; ++i) printf " %.0f", ($i >= 2012 ? $i + delta : $i); print " ]" }';
+}
+for args in "-d 0 -minl 4 -maxl 12 -ml 1024 -td build_wide" "-d 1 -minl 12 -maxl 12 -tr"; do
+  build_wide/ACME -i build_wide/wide_1000.txt -mb build_wide/wide_1000.bed -f 2 $args | grep -a -v '^#' | shiftPositions > build_wide/wide.answer;
+  build_wide/ACME -i build_wide/wide_$filler.txt -mb build_wide/wide_$filler.bed -f 2 $args | grep -a -v '^#' | cmp build_wide/wide.answer;
+done
+echo "wide test completed";